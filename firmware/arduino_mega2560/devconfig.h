@@ -23,6 +23,14 @@
 ****************************************/
 
 #define ENABLE_LED_DEVICE
+//#define LED_PWM_ENGINE LED_PWM_BAM  // soft-PWM engine for the LED outputs, see led.h
+//#define LED_SR_OUTPUTS 64  // outputs on 74HC595 shift registers at the SPI port instead of the pins, needs LED_PWM_BAM
+//#define LED_SR_INVERTED    // the shift register outputs are active low
+//#define LED_UNITS 2  // the outputs show up as this many LedWiz devices with consecutive IDs, 32 outputs each
+#define ENABLE_LED_TIMED      // LED_CMD_TIMED, a fifo of timed updates (132 bytes of RAM)
+#define ENABLE_LED_FADE       // LED_CMD_FADE, without it the targets are set at once (20 bytes of RAM per output)
+#define ENABLE_LED_SEQUENCER  // LED_CMD_SEQ, keyframe programs (about 230 bytes of RAM with the sizes in ledseq.h)
+#define ENABLE_LED_SCENE      // LED_CMD_SCENE, power-on scene in the EEPROM (a copy of the LED state in RAM)
 
 #define ENABLE_PANEL_DEVICE
 #define NUM_JOYSTICKS 2
@@ -31,6 +39,18 @@
 #define USE_KEYBOARD 1
 
 
+/****************************************
+ Data link config
+****************************************/
+
+#define DATA_UART_RATE_MAX 2  // the link between the controllers negotiates up to 0: 250 kBit/s, 1: 1 MBit/s, 2: 2 MBit/s
+                              // 2 MBit/s needs the RX interrupt within about 190 cycles, the LED interrupt blocks
+                              // for about 10 (it is up to 12900 cycles long, with interrupts enabled), see comm.c
+#define DATA_UART_BATCH 32    // queued LED messages are packed into link frames of less than 32 (or 64) bytes
+#define DATA_UART_CREDIT      // the LED controller tells how many frames it can take, the host is NAKed meanwhile
+#define DATA_UART_CHANNELS    // messages carry a channel, panel reports overtake queued LED and bulk messages
+
+
 
 #endif
 
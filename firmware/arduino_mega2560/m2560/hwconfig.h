@@ -1,153 +1,195 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
-
-#ifndef HWCONFIG_H__INCLUDED
-#define HWCONFIG_H__INCLUDED
-
-#include <stdint.h>
-#include <avr/io.h>
-
-#if (F_CPU != 16000000)
-#error "invalid CPU clock frequency ==> should be 16 MHZ"
-#endif
-
-#if !defined(__AVR_ATmega2560__ )
-#error "invalid CPU type ==> should be ATMega2560"
-#endif
-
-#include "../devconfig.h"
-#include "pinmap.h"
-
-
-/****************************************
- LED driver config
-****************************************/
-
-#if defined(ENABLE_LED_DEVICE)
-
-#define LED_TIMER_vect TIMER0_COMPA_vect
-
-static void inline led_timer_init(void)
-{
-	const int T0_CYCLE_US = 200;
-	OCR0A = (((T0_CYCLE_US * (F_CPU / 1000L)) / (64 * 1000L)) - 1);
-	TCCR0A = _BV(WGM01); // clear timer/counter on compare0 match
-	TCCR0B = _BV(CS01) |_BV(CS00); // prescale 64
-	TIMSK0 = _BV(OCIE0A); // enable Output Compare 0 overflow interrupt
-	TCNT0 = 0x00;
-}
-
-#endif
-
-
-/****************************************
- Panel config
-****************************************/
-
-#if defined(ENABLE_PANEL_DEVICE)
-#define PANEL_TASK
-#endif
-
-
-/****************************************
- ADC config
-****************************************/
-
-#if defined(ENABLE_ANALOG_INPUT)
-
-static void inline ADC_init(void)
-{
-	ADMUX = (1 << REFS0); // VCC with external capacitor on ARef pin
-
-	ADCSRA =
-		(1 << ADEN) | //enable 
-		(1 << ADSC) | //start conversion(s)
-		(1 << ADIE) | // interrupt enable
-		(1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0); // prescaler 128x
-}
-
-// https://ww1.microchip.com/downloads/en/devicedoc/atmel-2549-8-bit-avr-microcontroller-atmega640-1280-1281-2560-2561_datasheet.pdf
-// page 266 : 25.2.1
-#define ADCSRB_MUX5 3
-
-static void inline ADC_setmux(uint8_t mux)
-{
-	ADMUX &= ~0x1F;
-	ADMUX |= mux & 0x1F;
-	ADCSRB &= ~(1 << ADCSRB_MUX5);
-	ADCSRB |= (((mux >> 5) & 0x01) << ADCSRB_MUX5);
-}
-
-#endif
-
-
-/****************************************
- Clock config
-****************************************/
-
-#define CLOCK_COMPARE_MATCH_vect TIMER1_COMPA_vect
-#define CLOCK_TCNT TCNT1
-#define CLOCK_OCR OCR1A
-
-static void inline clock_init(void)
-{
-	OCR1A = TCNT1 + (F_CPU / 1000);
-	TCCR1B = _BV(CS10); //  normal mode, no prescale
-	TIMSK1 = _BV(OCIE1A); // enable Output Compare 1 interrupt
-}
-
-
-/****************************************
- Data UART config
-****************************************/
-
-#define DATA_TX_UART_vect   USART0_UDRE_vect
-#define DATA_RX_UART_vect   USART0_RX_vect
-
-#include "../../data_uart0.h"
-
-static void inline data_uart_init(void)
-{
-	UBRR0 = 3; // 250 kBit/s @ 16 MHz CPU
-	UCSR0C |= (1 << UCSZ01) | (1 << UCSZ00) | (1 << UPM01) | (1 << UPM00); // asynchron uart, odd parity, 9-bit-character, 1 stop bit
-	UCSR0B |= (1 << UCSZ02) | (1 << TXEN0) | (1 << RXEN0) | (1 << RXCIE0); // enable Receiver and Transmitter
-}
-
-
-/****************************************
- Debug UART config
-****************************************/
-
-#if defined(DEBUGLEVEL)
-
-#define DEBUG_TX_UART_vect   USART1_UDRE_vect
-
-static void inline debug_uart_setUDRIE(uint8_t x) { if (x) { UCSR1B |= (1 << UDRIE1); } else { UCSR1B &= ~(1 << UDRIE1); } }
-static void inline debug_uart_writeUDR(uint8_t x) { UDR1 = x; }
-
-static void inline debug_uart_init(void)
-{
-	UBRR1 = 16;  // 115200 bit/s @ 16MHz (==> 2.1% error)
-	UCSR1A |= (1 << U2X1);
-	UCSR1C = (3 << UCSZ10); // 1 stop, 8 data
-	UCSR1B |= (1 << TXEN1);
-}
-
-#endif
-
-
-
-#endif
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HWCONFIG_H__INCLUDED
+#define HWCONFIG_H__INCLUDED
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#if (F_CPU != 16000000)
+#error "invalid CPU clock frequency ==> should be 16 MHZ"
+#endif
+
+#if !defined(__AVR_ATmega2560__ )
+#error "invalid CPU type ==> should be ATMega2560"
+#endif
+
+#include "../devconfig.h"
+#include "pinmap.h"
+
+
+/****************************************
+ LED driver config
+****************************************/
+
+#if defined(ENABLE_LED_DEVICE)
+
+#define LED_TIMER_vect TIMER0_COMPA_vect
+#define LED_TIMER_OCR OCR0A
+#define LED_TIMER_TCNT TCNT0
+#define LED_TIMER_PRESCALER 64
+
+static void inline led_timer_init(void)
+{
+	const int T0_CYCLE_US = 200;
+	OCR0A = (((T0_CYCLE_US * (F_CPU / 1000L)) / (LED_TIMER_PRESCALER * 1000L)) - 1);
+	TCCR0A = _BV(WGM01); // clear timer/counter on compare0 match
+	TCCR0B = _BV(CS01) |_BV(CS00); // prescale 64
+	TIMSK0 = _BV(OCIE0A); // enable Output Compare 0 overflow interrupt
+	TCNT0 = 0x00;
+}
+
+// hardware PWM channels that can drive LED outputs instead of the soft-PWM, timer 0 and 1 are in use
+// and the outputs of timer 2, 3 and 4 are panel inputs
+// (port, pin, compare register, compare output register, compare output bits)
+
+#define LED_HWPWM_TABLE(_map_) \
+	_map_( L, 3, OCR5A,  TCCR5A, _BV(COM5A1) ) /* OC5A, Digital pin 46 */ \
+	_map_( L, 4, OCR5B,  TCCR5A, _BV(COM5B1) ) /* OC5B, Digital pin 45 */ \
+	_map_( L, 5, OCR5C,  TCCR5A, _BV(COM5C1) ) /* OC5C, Digital pin 44 */ \
+	/* end */
+
+static void inline led_hwpwm_timer_init(void)
+{
+	// timer 5: 8-bit phase correct PWM, prescale 64 (490 Hz)
+	TCCR5A = _BV(WGM50);
+	TCCR5B = _BV(CS51) | _BV(CS50);
+}
+
+// LED outputs on a chain of 74HC595 shift registers (LED_SR_OUTPUTS in devconfig.h):
+// MOSI (PB2, Digital pin 51) to SER of the first register, SCK (PB1, Digital pin 52) to all SRCLK,
+// SS (PB0, Digital pin 53) to all RCLK, /OE to GND, /SRCLR to VCC
+
+#if defined(LED_SR_OUTPUTS)
+
+static void inline led_sr_init(void)
+{
+	PORTB &= ~(_BV(PB0) | _BV(PB1) | _BV(PB2));
+	DDRB |= _BV(PB0) | _BV(PB1) | _BV(PB2);
+	SPCR = _BV(SPE) | _BV(MSTR); // SPI master, MSB first, mode 0
+	SPSR = _BV(SPI2X); // F_CPU / 2
+}
+
+static void inline led_sr_latch(void)
+{
+	PORTB |= _BV(PB0);
+	PORTB &= ~_BV(PB0);
+}
+
+#endif
+
+#endif
+
+
+/****************************************
+ Panel config
+****************************************/
+
+#if defined(ENABLE_PANEL_DEVICE)
+#define PANEL_TASK
+#endif
+
+
+/****************************************
+ ADC config
+****************************************/
+
+#if defined(ENABLE_ANALOG_INPUT)
+
+static void inline ADC_init(void)
+{
+	ADMUX = (1 << REFS0); // VCC with external capacitor on ARef pin
+
+	ADCSRA =
+		(1 << ADEN) | //enable 
+		(1 << ADSC) | //start conversion(s)
+		(1 << ADIE) | // interrupt enable
+		(1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0); // prescaler 128x
+}
+
+// https://ww1.microchip.com/downloads/en/devicedoc/atmel-2549-8-bit-avr-microcontroller-atmega640-1280-1281-2560-2561_datasheet.pdf
+// page 266 : 25.2.1
+#define ADCSRB_MUX5 3
+
+static void inline ADC_setmux(uint8_t mux)
+{
+	ADMUX &= ~0x1F;
+	ADMUX |= mux & 0x1F;
+	ADCSRB &= ~(1 << ADCSRB_MUX5);
+	ADCSRB |= (((mux >> 5) & 0x01) << ADCSRB_MUX5);
+}
+
+#endif
+
+
+/****************************************
+ Clock config
+****************************************/
+
+#define CLOCK_COMPARE_MATCH_vect TIMER1_COMPA_vect
+#define CLOCK_TCNT TCNT1
+#define CLOCK_OCR OCR1A
+
+static void inline clock_init(void)
+{
+	OCR1A = TCNT1 + (F_CPU / 1000);
+	TCCR1B = _BV(CS10); //  normal mode, no prescale
+	TIMSK1 = _BV(OCIE1A); // enable Output Compare 1 interrupt
+}
+
+
+/****************************************
+ Data UART config
+****************************************/
+
+#define DATA_TX_UART_vect   USART0_UDRE_vect
+#define DATA_RX_UART_vect   USART0_RX_vect
+
+#include "../../data_uart0.h"
+
+static void inline data_uart_init(void)
+{
+	UBRR0 = 3; // 250 kBit/s @ 16 MHz CPU, the link starts with that rate
+	UCSR0C |= (1 << UCSZ01) | (1 << UCSZ00) | (1 << UPM01) | (1 << UPM00); // asynchron uart, odd parity, 9-bit-character, 1 stop bit
+	UCSR0B |= (1 << UCSZ02) | (1 << TXEN0) | (1 << RXEN0) | (1 << RXCIE0); // enable Receiver and Transmitter
+}
+
+
+/****************************************
+ Debug UART config
+****************************************/
+
+#if defined(DEBUGLEVEL)
+
+#define DEBUG_TX_UART_vect   USART1_UDRE_vect
+
+static void inline debug_uart_setUDRIE(uint8_t x) { if (x) { UCSR1B |= (1 << UDRIE1); } else { UCSR1B &= ~(1 << UDRIE1); } }
+static void inline debug_uart_writeUDR(uint8_t x) { UDR1 = x; }
+
+static void inline debug_uart_init(void)
+{
+	UBRR1 = 16;  // 115200 bit/s @ 16MHz (==> 2.1% error)
+	UCSR1A |= (1 << U2X1);
+	UCSR1C = (3 << UCSZ10); // 1 stop, 8 data
+	UCSR1B |= (1 << TXEN1);
+}
+
+#endif
+
+
+
+#endif
@@ -36,17 +36,43 @@
 #if defined(ENABLE_LED_DEVICE)
 
 #define LED_TIMER_vect TIMER0_COMPA_vect
+#define LED_TIMER_OCR OCR0A
+#define LED_TIMER_TCNT TCNT0
+#define LED_TIMER_PRESCALER 64
 
 static void inline led_timer_init(void)
 {
 	const int T0_CYCLE_US = 200;
-	OCR0A = (((T0_CYCLE_US * (F_CPU / 1000L)) / (64 * 1000L)) - 1);
+	OCR0A = (((T0_CYCLE_US * (F_CPU / 1000L)) / (LED_TIMER_PRESCALER * 1000L)) - 1);
 	TCCR0A = _BV(WGM01); // clear timer/counter on compare0 match
 	TCCR0B = _BV(CS01) |_BV(CS00); // prescale 64
 	TIMSK0 = _BV(OCIE0A); // enable Output Compare 0 overflow interrupt
 	TCNT0 = 0x00;
 }
 
+// hardware PWM channels that can drive LED outputs instead of the soft-PWM, timer 0 and 1 are in use
+// (port, pin, compare register, compare output register, compare output bits)
+
+#define LED_HWPWM_TABLE(_map_) \
+	_map_( C, 6, OCR3A,  TCCR3A, _BV(COM3A1)              ) /* OC3A, Digital Pin 5 */ \
+	_map_( D, 7, OCR4D,  TCCR4C, _BV(COM4D1) | _BV(PWM4D) ) /* OC4D, Digital Pin 6 */ \
+	_map_( B, 6, OCR4B,  TCCR4A, _BV(COM4B1) | _BV(PWM4B) ) /* OC4B, Digital Pin 10 */ \
+	_map_( C, 7, OCR4A,  TCCR4A, _BV(COM4A1) | _BV(PWM4A) ) /* OC4A, Digital Pin 13 */ \
+	/* end */
+
+static void inline led_hwpwm_timer_init(void)
+{
+	// timer 3: 8-bit phase correct PWM, prescale 64 (490 Hz)
+	TCCR3A = _BV(WGM30);
+	TCCR3B = _BV(CS31) | _BV(CS30);
+
+	// timer 4: phase and frequency correct PWM with TOP = 255, prescale 64 (490 Hz)
+	TC4H = 0x00;
+	OCR4C = 0xFF;
+	TCCR4D = _BV(WGM40);
+	TCCR4B = _BV(CS42) | _BV(CS41) | _BV(CS40);
+}
+
 #endif
 
 
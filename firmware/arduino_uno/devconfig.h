@@ -23,6 +23,10 @@
 ****************************************/
 
 #define ENABLE_LED_DEVICE
+#define ENABLE_LED_TIMED      // LED_CMD_TIMED, a fifo of timed updates (132 bytes of RAM)
+#define ENABLE_LED_FADE       // LED_CMD_FADE, without it the targets are set at once (20 bytes of RAM per output)
+#define ENABLE_LED_SEQUENCER  // LED_CMD_SEQ, keyframe programs (about 230 bytes of RAM with the sizes in ledseq.h)
+#define ENABLE_LED_SCENE      // LED_CMD_SCENE, power-on scene in the EEPROM (a copy of the LED state in RAM)
 
 
 
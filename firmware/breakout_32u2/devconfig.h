@@ -23,6 +23,11 @@
 ****************************************/
 
 #define ENABLE_LED_DEVICE
+// the optional LED commands do not fit into the 1 KB of RAM next to the USB stack, see arduino_leonardo/devconfig.h
+//#define ENABLE_LED_TIMED
+//#define ENABLE_LED_FADE
+//#define ENABLE_LED_SEQUENCER
+//#define ENABLE_LED_SCENE
 
 #define ENABLE_PANEL_DEVICE
 #define NUM_JOYSTICKS 2
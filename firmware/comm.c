@@ -1,401 +1,1252 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
-
-#include <stdint.h>
-#include <stdio.h>
-#include <avr/interrupt.h>
-#include <avr/sleep.h>
-#include <util/atomic.h>
-
-#include "clock.h"
-#include "comm.h"
-
-extern FILE g_stdout_uart;
-
-
-void comm_init(void)
-{
-	#if defined(exit_bootloader)
-	exit_bootloader();
-	#endif
-
-	#if defined(DATA_TX_UART_vect) || defined(DATA_RX_UART_vect)
-	data_uart_init();
-	#endif
-
-	#if defined(DEBUG_TX_UART_vect) || defined(DEBUG_TX_SOFT_UART_vect)
-	debug_uart_init();
-	stdout = &g_stdout_uart;
-	#endif
-}
-
-
-#if defined(DEBUG_TX_UART_vect) || defined(DEBUG_TX_SOFT_UART_vect)
-
-CREATE_FIFO(g_dbgfifo, 7, 0)
-
-static int putchar_uart_txt(char c, FILE *stream);
-static int putchar_uart_raw(char c, FILE *stream);
-
-FILE g_stdout_uart = FDEV_SETUP_STREAM(putchar_uart_txt, NULL, _FDEV_SETUP_WRITE);
-
-static int putchar_uart_raw(char c, FILE *stream)
-{
-	for (;;)
-	{
-		if (0 == queue_push(g_dbgfifo, c)) {
-			break;
-		}
-	}
-
-	debug_uart_setUDRIE(1);
-
-	return 0;
-}
-
-static int putchar_uart_txt(char c, FILE *stream)
-{
-	if (c == '\n') {
-		putchar_uart_raw('\r', stream);
-	}
-
-	putchar_uart_raw(c, stream);
-
-	return 0;
-}
-
-#if defined(DEBUG_TX_UART_vect)
-
-ISR(DEBUG_TX_UART_vect)
-{
-	#if defined(ENABLE_PROFILING)
-	profile_start();
-	#endif
-
-	uint8_t x;
-
-	int8_t res = queue_pop(g_dbgfifo, &x);
-
-	if (res != 0)
-	{
-		debug_uart_setUDRIE(0);
-		return;
-	}
-
-	debug_uart_writeUDR(x);
-}
-
-#elif defined(DEBUG_TX_SOFT_UART_vect)
-
-#define BAUDRATE 9600
-#define DURATION_TXBIT ((F_CPU/8 + (BAUDRATE/2)) / BAUDRATE)
-
-ISR(DEBUG_TX_SOFT_UART_vect)
-{
-	#if defined(ENABLE_PROFILING)
-	profile_start();
-	#endif
-
-	OCR0A += DURATION_TXBIT;
-
-	static uint8_t count = 0;
-	static uint8_t x = 0;
-
-	if (count == 0)
-	{
-		int8_t res = queue_pop(g_dbgfifo, &x);
-
-		if (res != 0)
-		{
-			debug_uart_setUDRIE(0);
-			return;
-		}
-
-		x = ~x;        // invert data for Stop bit generation
-		count = 9;     // 10 bits: Start + data + Stop
-
-		TCCR0A = 1 << COM0A1; // clear on next compare
-
-		return;
-	}
-
-	if (count)
-	{
-		count--;
-		TCCR0A = 1 << COM0A1; // clear on next compare
-
-		// no start bit
-		if (!(x & 0x01)) // test inverted data
-			TCCR0A = (1 << COM0A1) | (1 << COM0A0); // set on next compare
-
-		x >>= 1; // shift zero in from left
-	}
-}
-
-#endif
-#endif
-
-#if defined(ENABLE_PROFILING)
-
-static volatile uint8_t s_profiling = 0;
-static volatile uint32_t s_t_start = 0;
-
-void profile_stop(void)
-{
-	if (!s_profiling) {
-		return;
-	}
-
-	uint32_t t_now = clock();
-	uint32_t duration;
-
-	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
-	{
-		duration = t_now - s_t_start;
-		s_profiling = 0;
-	}
-
-	static uint32_t duration_total = 0;
-	static uint32_t t_start_total = 0;
-
-	if (t_start_total == 0)
-	{
-		t_start_total = t_now;
-		duration_total = 0;
-		return;
-	}
-
-	duration_total += duration;
-
-	if ((t_now - t_start_total) > (((uint32_t)1 << 18) * 100)) {
-		MsgOut("\rCPU usage: %2d%%", (uint16_t)(duration_total >> 18));
-		t_start_total = t_now;
-		duration_total = 0;
-	}
-}
-
-void profile_start(void)
-{
-	if (!s_profiling) {
-		s_profiling = 1;
-		s_t_start = clock();
-	}
-}
-
-#endif
-
-
-void sleep_ms(uint16_t ms)
-{
-	if (ms > 0) {
-		ms = clock_ms() + ms;
-	}
-
-	for (;;)
-	{
-		#if defined(ENABLE_PROFILING)
-		profile_stop();
-		#endif
-
-		sleep_mode();
-
-		if (ms == 0) {
-			break;
-		}
-
-		uint16_t const t_now = clock_ms();
-
-		if (((int16_t)t_now - (int16_t)ms) >= 0) {
-			break;
-		}
-	}
-}
-
-
-#if defined(DATA_TX_UART_vect)
-
-CREATE_FIFO(g_txfifo, 2, 4)
-
-msg_t* msg_prepare(void)
-{
-	uint8_t * const pdata = chunk_prepare(g_txfifo);
-
-	if (pdata == NULL) {
-		return NULL;
-	}
-
-	return (msg_t*)pdata;
-}
-
-void msg_send(void)
-{
-	chunk_push(g_txfifo);
-	uart_setUDRIE(1);
-}
-
-ISR(DATA_TX_UART_vect)
-{
-	#if defined(ENABLE_PROFILING)
-	profile_start();
-	#endif
-
-	static uint8_t nbytes = 0;
-	static uint8_t * pdata = NULL;
-
-	// start new data frame?
-
-	if (nbytes == 0)
-	{
-		pdata = chunk_peek(g_txfifo);
-
-		if (pdata == NULL)
-		{
-			//clear UDRE interrupt
-			uart_setUDRIE(0);
-			return; // end of transmission
-		}
-
-		uint8_t const nlen = pdata[0];
-
-		if (nlen >= g_txfifo->chunksize)
-		{
-			DbgOut(DBGERROR, "ISR(TX), invalid argument nlen");
-			chunk_release(g_txfifo);
-			return;
-		}
-
-		uart_setBIT8TX(1);  // set 9nth bit
-
-		nbytes = nlen + 1;
-	}
-	else
-	{
-		uart_setBIT8TX(0);  // clear 9nth bit
-	}
-
-	// transmit byte
-
-	uart_writeUDR(*pdata++);
-	nbytes--;
-
-	// advance fifo
-
-	if (nbytes == 0)
-		chunk_release(g_txfifo);
-}
-
-#endif
-
-
-#if defined(DATA_RX_UART_vect)
-
-CREATE_FIFO(g_rxfifo, 2, 4)
-
-msg_t* msg_recv(void)
-{
-	uint8_t * const pdata = chunk_peek(g_rxfifo);
-
-	if (pdata == NULL) {
-		return NULL;
-	}
-
-	return (msg_t*)pdata;
-}
-
-void msg_release(void)
-{
-	chunk_release(g_rxfifo);
-}
-
-ISR(DATA_RX_UART_vect)
-{
-	#if defined(ENABLE_PROFILING)
-	profile_start();
-	#endif
-
-	static uint8_t nbytes = 0;
-	static uint8_t * pdata = NULL;
-
-	uint8_t e = uart_getError();
-	uint8_t s = uart_getBIT8RX();
-	uint8_t b = uart_readUDR();
-
-	// check error condition
-
-	if (e)
-	{
-		#if 0
-		if (e & (1 << FE0))
-			DbgOut(DBGERROR, "ISR(rx), FE0");
-
-		if (e & (1 << DOR0))
-			DbgOut(DBGERROR, "ISR(rx), DOR0");
-
-		if (e & (1 << UPE0))
-			DbgOut(DBGERROR, "ISR(rx), UPE0");
-		#endif
-
-		nbytes = 0;
-		return;
-	}
-
-	// sync to start of frame, i.e. bit 8 is set
-
-	if (s) 
-	{
-		if (nbytes > 0)
-		{
-			DbgOut(DBGERROR, "ISR(rx), nbytes > 0");
-		}
-
-		nbytes = 0;
-	}
-
-	if (nbytes == 0)
-	{
-		if (!s) {
-			DbgOut(DBGERROR, "ISR(rx), !s");
-			return;
-		}
-
-		if (b >= g_rxfifo->chunksize) {
-			DbgOut(DBGERROR, "ISR(rx), message size to big");
-			return;
-		}
-
-		pdata = chunk_prepare(g_rxfifo);
-
-		if (pdata == NULL)
-		{
-			DbgOut(DBGERROR, "ISR(rx), buffer full");
-			return;
-		}
-
-		nbytes = b + 1;
-	}
-
-	// store byte
-
-	*pdata++ = b;
-	nbytes--;
-
-	// commit the message
-
-	if (nbytes == 0)
-		chunk_push(g_rxfifo);
-}
-
-#endif
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+#include "clock.h"
+#include "comm.h"
+
+extern FILE g_stdout_uart;
+
+#if defined(DATA_UART_RATE_MAX)
+static void link_init(void);
+#endif
+
+#if defined(DATA_UART_CREDIT) && !defined(DATA_UART_MASTER)
+static uint8_t link_credit(void);
+static void link_credit_changed(void);
+#endif
+
+
+void comm_init(void)
+{
+	#if defined(exit_bootloader)
+	exit_bootloader();
+	#endif
+
+	#if defined(DATA_TX_UART_vect) || defined(DATA_RX_UART_vect)
+	data_uart_init();
+	#endif
+
+	#if defined(DATA_UART_RATE_MAX)
+	link_init();
+	#endif
+
+	#if defined(DEBUG_TX_UART_vect) || defined(DEBUG_TX_SOFT_UART_vect)
+	debug_uart_init();
+	stdout = &g_stdout_uart;
+	#endif
+}
+
+
+#if defined(DEBUG_TX_UART_vect) || defined(DEBUG_TX_SOFT_UART_vect)
+
+CREATE_FIFO(g_dbgfifo, 7, 0)
+
+static int putchar_uart_txt(char c, FILE *stream);
+static int putchar_uart_raw(char c, FILE *stream);
+
+FILE g_stdout_uart = FDEV_SETUP_STREAM(putchar_uart_txt, NULL, _FDEV_SETUP_WRITE);
+
+static int putchar_uart_raw(char c, FILE *stream)
+{
+	for (;;)
+	{
+		if (0 == queue_push(g_dbgfifo, c)) {
+			break;
+		}
+	}
+
+	debug_uart_setUDRIE(1);
+
+	return 0;
+}
+
+static int putchar_uart_txt(char c, FILE *stream)
+{
+	if (c == '\n') {
+		putchar_uart_raw('\r', stream);
+	}
+
+	putchar_uart_raw(c, stream);
+
+	return 0;
+}
+
+#if defined(DEBUG_TX_UART_vect)
+
+ISR(DEBUG_TX_UART_vect)
+{
+	#if defined(ENABLE_PROFILING)
+	profile_start();
+	#endif
+
+	uint8_t x;
+
+	int8_t res = queue_pop(g_dbgfifo, &x);
+
+	if (res != 0)
+	{
+		debug_uart_setUDRIE(0);
+		return;
+	}
+
+	debug_uart_writeUDR(x);
+}
+
+#elif defined(DEBUG_TX_SOFT_UART_vect)
+
+#define BAUDRATE 9600
+#define DURATION_TXBIT ((F_CPU/8 + (BAUDRATE/2)) / BAUDRATE)
+
+ISR(DEBUG_TX_SOFT_UART_vect)
+{
+	#if defined(ENABLE_PROFILING)
+	profile_start();
+	#endif
+
+	OCR0A += DURATION_TXBIT;
+
+	static uint8_t count = 0;
+	static uint8_t x = 0;
+
+	if (count == 0)
+	{
+		int8_t res = queue_pop(g_dbgfifo, &x);
+
+		if (res != 0)
+		{
+			debug_uart_setUDRIE(0);
+			return;
+		}
+
+		x = ~x;        // invert data for Stop bit generation
+		count = 9;     // 10 bits: Start + data + Stop
+
+		TCCR0A = 1 << COM0A1; // clear on next compare
+
+		return;
+	}
+
+	if (count)
+	{
+		count--;
+		TCCR0A = 1 << COM0A1; // clear on next compare
+
+		// no start bit
+		if (!(x & 0x01)) // test inverted data
+			TCCR0A = (1 << COM0A1) | (1 << COM0A0); // set on next compare
+
+		x >>= 1; // shift zero in from left
+	}
+}
+
+#endif
+#endif
+
+#if defined(ENABLE_PROFILING)
+
+static volatile uint8_t s_profiling = 0;
+static volatile uint32_t s_t_start = 0;
+static volatile uint16_t s_isr_peak = 0;
+
+void profile_stop(void)
+{
+	if (!s_profiling) {
+		return;
+	}
+
+	uint32_t t_now = clock();
+	uint32_t duration;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		duration = t_now - s_t_start;
+		s_profiling = 0;
+	}
+
+	static uint32_t duration_total = 0;
+	static uint32_t t_start_total = 0;
+
+	if (t_start_total == 0)
+	{
+		t_start_total = t_now;
+		duration_total = 0;
+		return;
+	}
+
+	duration_total += duration;
+
+	if ((t_now - t_start_total) > (((uint32_t)1 << 18) * 100))
+	{
+		uint16_t isr_peak;
+
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			isr_peak = s_isr_peak;
+			s_isr_peak = 0;
+		}
+
+		MsgOut("\rCPU usage: %2d%%, ISR peak: %5u cycles", (uint16_t)(duration_total >> 18), isr_peak);
+		t_start_total = t_now;
+		duration_total = 0;
+	}
+}
+
+void profile_start(void)
+{
+	if (!s_profiling) {
+		s_profiling = 1;
+		s_t_start = clock();
+	}
+}
+
+void profile_isr(uint16_t cycles)
+{
+	// timer 1 cycles from the start to the end of the interrupt, the register saving is not included
+
+	if (cycles > s_isr_peak) {
+		s_isr_peak = cycles;
+	}
+}
+
+#endif
+
+
+void sleep_ms(uint16_t ms)
+{
+	if (ms > 0) {
+		ms = clock_ms() + ms;
+	}
+
+	for (;;)
+	{
+		#if defined(ENABLE_PROFILING)
+		profile_stop();
+		#endif
+
+		sleep_mode();
+
+		if (ms == 0) {
+			break;
+		}
+
+		uint16_t const t_now = clock_ms();
+
+		if (((int16_t)t_now - (int16_t)ms) >= 0) {
+			break;
+		}
+	}
+}
+
+
+// Link rate negotiation between the two controllers of a board: both start at the safe rate of
+// data_uart_init(). The USB controller (DATA_UART_MASTER) asks for a faster rate with LINK_REQ, the
+// other side answers with LINK_ACK and the rate it takes, both switch and the master checks the new
+// rate with a LINK_CHECK that is echoed. A framing error, a run of other line errors or a missing
+// answer fall back to the safe rate, the master then tries the next slower one. The control bytes
+// are frame starts (9th bit set) with values that can not be the length of a message.
+//
+// At 2 MBit/s a 12 bit frame (9 data bits, parity) takes 96 cycles at 16 MHz. The UART buffers two
+// received bytes, so no other interrupt may hold off the RX interrupt for much more than 190 cycles.
+// The LED interrupt of the m2560 runs up to 12900 cycles at the start of a period and about 240 on
+// every other tick (tick engine, 56 outputs). So it runs with interrupts enabled and blocks them
+// only for its entry, about 10 cycles, see led.c.
+
+#if defined(DATA_UART_RATE_MAX)
+
+#if !defined(DATA_TX_UART_vect) || !defined(DATA_RX_UART_vect)
+	#error "DATA_UART_RATE_MAX needs both data UART directions"
+#endif
+
+#define LINK_CTRL    0x80
+#define LINK_REQ     0x80   // master: switch to the rate in the low nibble
+#define LINK_ACK     0x90   // slave: switching to the rate in the low nibble
+#define LINK_CHECK   0xA0   // master: test byte at the new rate, slave: echo
+#define LINK_RESET   0xB0   // slave: back at the safe rate (after a reset or an error)
+#define LINK_CREDIT  0xC0   // slave: the master may send up to the frame count in the low nibble
+#define LINK_SYNC    0xD0   // master: frames sent so far, in the low nibble
+#define LINK_OP      0xF0
+#define LINK_RATE    0x0F
+#define LINK_COUNT   0x0F
+
+#define LINK_TIMEOUT_MS    20    // for the answer to LINK_REQ and LINK_CHECK
+#define LINK_SETTLE_MS     5     // the slave switches from its main loop, give it some time
+#define LINK_RETRIES       16    // LINK_REQ attempts, the slave may still be starting up
+#define LINK_CHECKS        3     // LINK_CHECK attempts
+#define LINK_WAIT_MS       100   // slave: longer than all LINK_CHECK attempts of the master
+#define LINK_MAX_ERRORS    8     // overrun/parity errors ...
+#define LINK_GOOD_FRAMES   64    // ... within this many good frames
+#define LINK_STABLE_MS     1000  // master: a link that fails after running this long starts over at the top rate
+
+static struct {
+	uint8_t ubrr;
+	uint8_t u2x;
+} const g_link_rates[] = {
+	{ 3, 0 },  // 250 kBit/s @ 16 MHz, as in data_uart_init()
+	{ 1, 1 },  // 1 MBit/s
+	{ 0, 1 },  // 2 MBit/s
+};
+
+#if (DATA_UART_RATE_MAX < 0) || (DATA_UART_RATE_MAX >= 3)
+	#error "DATA_UART_RATE_MAX must be 0..2"
+#endif
+
+enum {
+	LINK_STATE_UP = 0,    // data messages flow
+	LINK_STATE_REQUEST,   // master: LINK_REQ sent
+	LINK_STATE_SWITCH,    // master: waits before LINK_CHECK, slave: LINK_ACK is being sent
+	LINK_STATE_CHECK,     // master: LINK_CHECK sent, slave: waits for it
+};
+
+static volatile uint8_t g_link_up = 1;     // data messages may be sent
+static volatile uint8_t g_link_tx = 0;     // control byte to send before the next message, 0 if none
+static volatile uint8_t g_link_rx = 0;     // last control byte received, 0 if none
+static volatile uint8_t g_link_fail = 0;   // the line is broken at the current rate
+static uint8_t g_link_nerrors = 0;         // owned by the RX interrupt
+static uint8_t g_link_ngood = 0;
+
+static uint8_t g_link_state = LINK_STATE_UP;
+static uint8_t g_link_rate = 0;
+static uint8_t g_link_rate_max = DATA_UART_RATE_MAX;
+#if defined(DATA_UART_MASTER)
+static uint8_t g_link_retries = 0;
+static uint8_t g_link_stable = 0;          // the link has been up for LINK_STABLE_MS
+static uint16_t g_link_t_open = 0;
+#endif
+static uint16_t g_link_t0 = 0;
+
+#endif
+
+
+// Credit flow control: with DATA_UART_CREDIT the slave counts the frames it has received and sends
+// LINK_CREDIT with the count (modulo 16) up to which its receive fifo has room. The master holds the
+// frames beyond that in its own fifo, so msg_prepare() fails and the USB host is NAKed instead of the
+// slave dropping frames when its main loop is busy. A frame that is lost on the line shrinks the
+// window, so a master that is waiting for credit sends LINK_SYNC with its own count every
+// LINK_SYNC_MS, the slave takes it over and answers with LINK_CREDIT. Without an answer the master
+// runs without credit again until the next LINK_CREDIT, e.g. with an old firmware on the other side.
+
+#if defined(DATA_UART_CREDIT)
+
+	#if !defined(DATA_UART_RATE_MAX)
+		#error "DATA_UART_CREDIT needs DATA_UART_RATE_MAX"
+	#endif
+
+	#define LINK_WINDOW   8   // more credit than this is a stale LINK_CREDIT
+	#define LINK_SYNC_MS  4   // the slave answers LINK_SYNC from its interrupt, so this can be short
+
+	#if defined(DATA_UART_MASTER)
+		static volatile uint8_t g_link_credit = 0;   // the slave sends LINK_CREDIT
+		static volatile uint8_t g_link_limit = 0;    // frame count up to which we may send
+		static volatile uint8_t g_link_ncredit = 0;  // LINK_CREDIT bytes received
+		static volatile uint8_t g_link_starved = 0;  // frames are held for credit
+		static uint8_t g_link_nsent = 0;             // owned by the TX interrupt
+		static uint8_t g_link_ncredit_seen = 0;
+	#else
+		static volatile uint8_t g_link_credit_tx = 0;  // LINK_CREDIT to send before the next message
+		static uint8_t g_link_nrecv = 0;               // owned by the RX interrupt
+	#endif
+
+#endif
+
+
+// Batch frames: with DATA_UART_BATCH the master packs the messages that are queued when a frame
+// starts into one frame [LINK_BATCH | size, (nlen, data) * n] of less than DATA_UART_BATCH bytes, the
+// slave keeps such a frame in one record of its receive fifo. A burst of small LED messages (e.g. SBA
+// and four PBA reports that arrive back to back) then takes a few frames and credits instead of one
+// each and the main loop has more time until the fifo is full. A single message is sent as before.
+
+#define LINK_BATCH   0x40
+
+#if defined(DATA_UART_BATCH)
+
+	#if (DATA_UART_BATCH != 32) && (DATA_UART_BATCH != 64)
+		#error "DATA_UART_BATCH must be 32 or 64"
+	#endif
+
+	#if defined(DATA_UART_MASTER) && defined(DATA_TX_UART_vect)
+		#define LINK_BATCH_TX
+	#endif
+
+	#if !defined(DATA_UART_MASTER) && defined(DATA_RX_UART_vect)
+		#define LINK_BATCH_RX
+	#endif
+
+#endif
+
+
+// Channels: with DATA_UART_CHANNELS every message belongs to a channel (MSG_CHANNEL_xxx in comm.h)
+// that is sent in bits 4..5 of its length byte, so old frames are LED messages on channel 0. Each
+// channel has its own transmit fifo and the TX interrupt starts the next frame from the channel with
+// the highest priority: panel input, then LED data, then bulk data. A panel report waits for at most
+// the frame that is already on the line, not for the queued LED or bulk messages in front of it.
+
+#if defined(DATA_UART_CHANNELS)
+	#define LINK_LENGTH(b)   ((b) & 0x0F)
+	#define LINK_CHANNEL(b)  ((b) >> 4)
+#else
+	#define LINK_LENGTH(b)   (b)
+	#define LINK_CHANNEL(b)  MSG_CHANNEL_LED
+#endif
+
+
+#if defined(DATA_TX_UART_vect)
+
+// the messages are the records of the transmit fifos, so a short message takes only its own size.
+// msg_prepare() asks for the longest message, and up to MSG_MAXLEN bytes before the end of the buffer
+// may be skipped for it, so a fifo of less than 2 * (MSG_MAXLEN + 1) bytes can stay full forever
+
+#define TX_FIFO_LOG2        6
+#define TX_FIFO_PANEL_LOG2  5
+#define TX_FIFO_BULK_LOG2   5
+
+#if ((1 << TX_FIFO_LOG2) < 2 * (MSG_MAXLEN + 1)) || \
+    ((1 << TX_FIFO_PANEL_LOG2) < 2 * (MSG_MAXLEN + 1)) || \
+    ((1 << TX_FIFO_BULK_LOG2) < 2 * (MSG_MAXLEN + 1))
+	#error "the transmit fifos must hold at least 2 * (MSG_MAXLEN + 1) bytes"
+#endif
+
+CREATE_RFIFO(g_txfifo, TX_FIFO_LOG2)
+
+#if defined(DATA_UART_CHANNELS)
+
+CREATE_RFIFO(g_txfifo_panel, TX_FIFO_PANEL_LOG2)
+CREATE_RFIFO(g_txfifo_bulk, TX_FIFO_BULK_LOG2)
+
+static rfifo_t * tx_fifo(uint8_t channel)
+{
+	switch (channel)
+	{
+	case MSG_CHANNEL_PANEL: return g_txfifo_panel;
+	case MSG_CHANNEL_BULK:  return g_txfifo_bulk;
+	default:                return g_txfifo;
+	}
+}
+
+// the channel of the next frame, MSG_CHANNELS if there is nothing to send
+
+static uint8_t tx_schedule(void)
+{
+	static uint8_t const order[] = { MSG_CHANNEL_PANEL, MSG_CHANNEL_LED, MSG_CHANNEL_BULK };
+
+	for (uint8_t i = 0; i < sizeof(order); i++)
+	{
+		if (record_peek(tx_fifo(order[i])) != NULL)
+			return order[i];
+	}
+
+	return MSG_CHANNELS;
+}
+
+static uint8_t g_txchannel = MSG_CHANNEL_LED;  // channel of the last msg_prepare()
+
+#else
+
+#define tx_fifo(channel) g_txfifo
+
+#endif
+
+#if defined(DATA_UART_CREDIT) && defined(DATA_UART_MASTER)
+
+static uint8_t link_has_credit(void)
+{
+	uint8_t const n = (g_link_limit - g_link_nsent) & LINK_COUNT;
+
+	return (n > 0) && (n <= LINK_WINDOW);
+}
+
+#endif
+
+#if defined(LINK_BATCH_TX)
+
+// size of a batch frame with the messages that are queued right now, 0 if it would be just one
+
+static uint8_t batch_size(rfifo_t *f)
+{
+	uint8_t size = 0;
+	uint8_t n = 0;
+
+	for (uint8_t *p = record_peek(f); p != NULL; p = record_next(f, p))
+	{
+		uint8_t const k = p[0] + 1;
+
+		if (p[0] > MSG_MAXLEN || size + k >= DATA_UART_BATCH)
+			break;
+
+		size += k;
+		n++;
+	}
+
+	return (n > 1) ? size : 0;
+}
+
+#endif
+
+msg_t* msg_prepare(uint8_t channel)
+{
+	#if defined(DATA_UART_CHANNELS)
+	g_txchannel = channel;
+	#endif
+
+	uint8_t * const pdata = record_prepare(tx_fifo(channel), MSG_MAXLEN + 1);
+
+	if (pdata == NULL) {
+		return NULL;
+	}
+
+	return (msg_t*)pdata;
+}
+
+void msg_send(void)
+{
+	record_push(tx_fifo(g_txchannel));
+	uart_setUDRIE(1);
+}
+
+ISR(DATA_TX_UART_vect)
+{
+	#if defined(ENABLE_PROFILING)
+	profile_start();
+	#endif
+
+	static uint8_t nframe = 0;  // bytes left in the frame
+	static uint8_t nbytes = 0;  // bytes left in the current message
+	static uint8_t * pdata = NULL;
+
+	#if defined(DATA_UART_CHANNELS)
+	static uint8_t channel = MSG_CHANNEL_LED;
+	#endif
+
+	rfifo_t * f = tx_fifo(channel);
+	uint8_t tag = 0; // channel bits of the first byte of a message
+
+	// start new data frame?
+
+	if (nframe == 0)
+	{
+		#if defined(DATA_UART_RATE_MAX)
+
+		if (g_link_tx != 0)
+		{
+			uint8_t ctrl = g_link_tx;
+
+			#if defined(DATA_UART_CREDIT) && defined(DATA_UART_MASTER)
+			if (ctrl == LINK_SYNC) {
+				ctrl |= g_link_nsent & LINK_COUNT;
+			}
+			#endif
+
+			uart_setBIT8TX(1);
+			uart_clearTXC();
+			uart_writeUDR(ctrl);
+			g_link_tx = 0;
+			return;
+		}
+
+		if (!g_link_up)
+		{
+			uart_setUDRIE(0);
+			return; // hold the messages while the rate changes
+		}
+
+		#endif
+
+		#if defined(DATA_UART_CREDIT) && !defined(DATA_UART_MASTER)
+
+		if (g_link_credit_tx)
+		{
+			uart_setBIT8TX(1);
+			uart_writeUDR(LINK_CREDIT | link_credit());
+			g_link_credit_tx = 0;
+			return;
+		}
+
+		#endif
+
+		#if defined(DATA_UART_CHANNELS)
+
+		channel = tx_schedule();
+
+		if (channel == MSG_CHANNELS)
+		{
+			channel = MSG_CHANNEL_LED;
+			uart_setUDRIE(0);
+			return; // end of transmission
+		}
+
+		f = tx_fifo(channel);
+		tag = channel << 4;
+
+		#endif
+
+		pdata = record_peek(f);
+
+		if (pdata == NULL)
+		{
+			//clear UDRE interrupt
+			uart_setUDRIE(0);
+			return; // end of transmission
+		}
+
+		#if defined(DATA_UART_CREDIT) && defined(DATA_UART_MASTER)
+
+		if (g_link_credit && !link_has_credit())
+		{
+			g_link_starved = 1;
+			uart_setUDRIE(0);
+			return; // hold the messages until the slave has room
+		}
+
+		#endif
+
+		uint8_t const nlen = pdata[0];
+
+		if (nlen > MSG_MAXLEN)
+		{
+			DbgOut(DBGERROR, "ISR(TX), invalid argument nlen");
+			record_release(f, 1);
+			return;
+		}
+
+		uart_setBIT8TX(1);  // set 9nth bit
+
+		#if defined(DATA_UART_CREDIT) && defined(DATA_UART_MASTER)
+		g_link_nsent++;
+		#endif
+
+		#if defined(LINK_BATCH_TX)
+
+		uint8_t const nbatch = batch_size(f);
+
+		if (nbatch > 0)
+		{
+			uart_writeUDR(LINK_BATCH | nbatch);
+			nframe = nbatch;
+			nbytes = 0;
+			return;
+		}
+
+		#endif
+
+		nframe = nlen + 1;
+		nbytes = nlen + 1;
+	}
+	else
+	{
+		uart_setBIT8TX(0);  // clear 9nth bit
+
+		// next message of a batch frame
+
+		if (nbytes == 0)
+		{
+			pdata = record_peek(f);
+			nbytes = pdata[0] + 1;
+
+			#if defined(DATA_UART_CHANNELS)
+			tag = channel << 4;
+			#endif
+		}
+	}
+
+	// transmit byte
+
+	uart_writeUDR(*pdata++ | tag);
+	nbytes--;
+	nframe--;
+
+	// advance fifo
+
+	if (nbytes == 0)
+		record_release(f, 1);
+}
+
+#endif
+
+
+#if defined(DATA_RX_UART_vect)
+
+#if defined(DATA_UART_CHANNELS)
+
+static uint8_t g_rxchannel = MSG_CHANNEL_LED;  // channel of the message from msg_recv()
+
+// the first msg_recv() of a message takes the channel bits off its length byte
+
+static msg_t* rx_message(uint8_t *pmsg)
+{
+	if (LINK_CHANNEL(pmsg[0]) != MSG_CHANNEL_LED)
+	{
+		g_rxchannel = LINK_CHANNEL(pmsg[0]);
+		pmsg[0] = LINK_LENGTH(pmsg[0]);
+	}
+
+	return (msg_t*)pmsg;
+}
+
+uint8_t msg_channel(void)
+{
+	return g_rxchannel;
+}
+
+#define rx_message_done() do { g_rxchannel = MSG_CHANNEL_LED; } while (0)
+
+#else
+
+#define rx_message(pmsg) ((msg_t*)(pmsg))
+#define rx_message_done() do {} while (0)
+
+uint8_t msg_channel(void)
+{
+	return MSG_CHANNEL_LED;
+}
+
+#endif
+
+// a frame is one record of the receive fifo, [size, (nlen, data) * n], with a single message for a
+// plain frame and several for a batch frame. The m2560 has the RAM for a larger fifo.
+
+#if defined(LINK_BATCH_RX)
+	#define LINK_FRAME_MAX  (DATA_UART_BATCH - 1)
+	#define RX_FIFO_LOG2    9
+#else
+	#define LINK_FRAME_MAX  (MSG_MAXLEN + 1)
+	#define RX_FIFO_LOG2    6
+#endif
+
+#if ((1 << RX_FIFO_LOG2) < 2 * (LINK_FRAME_MAX + 1))
+	#error "the receive fifo must hold at least 2 * (LINK_FRAME_MAX + 1) bytes"
+#endif
+
+CREATE_RFIFO(g_rxfifo, RX_FIFO_LOG2)
+
+static uint8_t g_rxoffset = 0;  // offset of the current message in the record
+
+msg_t* msg_recv(void)
+{
+	uint8_t * const pdata = record_peek(g_rxfifo);
+
+	if (pdata == NULL) {
+		return NULL;
+	}
+
+	return rx_message(&pdata[1 + g_rxoffset]);
+}
+
+void msg_release(void)
+{
+	uint8_t const * const pdata = record_peek(g_rxfifo);
+
+	rx_message_done();
+	g_rxoffset += LINK_LENGTH(pdata[1 + g_rxoffset]) + 1;
+
+	if (g_rxoffset < pdata[0])
+		return;
+
+	g_rxoffset = 0;
+	record_release(g_rxfifo, 1);
+
+	#if defined(DATA_UART_CREDIT) && !defined(DATA_UART_MASTER)
+	link_credit_changed();
+	#endif
+}
+
+// the messages of a frame have to fill it exactly
+
+static uint8_t frame_valid(uint8_t const *pframe)
+{
+	uint8_t k = 0;
+
+	while (k < pframe[0])
+	{
+		uint8_t const b = pframe[1 + k];
+
+		if (LINK_LENGTH(b) > MSG_MAXLEN || LINK_CHANNEL(b) >= MSG_CHANNELS)
+			return 0;
+
+		k += LINK_LENGTH(b) + 1;
+	}
+
+	return k == pframe[0];
+}
+
+#if defined(DATA_UART_CREDIT) && !defined(DATA_UART_MASTER)
+
+// frame count up to which the master may send, the received frames and the frames of the largest
+// size that fit into the receive fifo
+
+static uint8_t link_credit(void)
+{
+	uint16_t const nfree = record_getfree(g_rxfifo, LINK_FRAME_MAX + 1);
+
+	return (g_link_nrecv + ((nfree < LINK_WINDOW) ? nfree : LINK_WINDOW)) & LINK_COUNT;
+}
+
+static void link_credit_changed(void)
+{
+	g_link_credit_tx = 1;
+	uart_setUDRIE(1);
+}
+
+#endif
+
+// count a frame that is stored or dropped, the credit of the master is based on it
+
+#if defined(DATA_UART_CREDIT) && !defined(DATA_UART_MASTER)
+	#define LINK_FRAME_DONE() do { g_link_nrecv++; link_credit_changed(); } while (0)
+#else
+	#define LINK_FRAME_DONE() do {} while (0)
+#endif
+
+ISR(DATA_RX_UART_vect)
+{
+	#if defined(ENABLE_PROFILING)
+	profile_start();
+	#endif
+
+	static uint8_t nbytes = 0;
+	static uint8_t * pdata = NULL;
+	static uint8_t * pframe = NULL;
+
+	uint8_t e = uart_getError();
+	uint8_t s = uart_getBIT8RX();
+	uint8_t b = uart_readUDR();
+
+	// check error condition
+
+	if (e)
+	{
+		#if 0
+		if (e & (1 << FE0))
+			DbgOut(DBGERROR, "ISR(rx), FE0");
+
+		if (e & (1 << DOR0))
+			DbgOut(DBGERROR, "ISR(rx), DOR0");
+
+		if (e & (1 << UPE0))
+			DbgOut(DBGERROR, "ISR(rx), UPE0");
+		#endif
+
+		#if defined(DATA_UART_RATE_MAX)
+		if ((e & UART_ERROR_FE) || ++g_link_nerrors >= LINK_MAX_ERRORS)
+		{
+			g_link_fail = 1;
+			g_link_nerrors = 0;
+		}
+		#endif
+
+		nbytes = 0;
+		return;
+	}
+
+	// sync to start of frame, i.e. bit 8 is set
+
+	if (s) 
+	{
+		if (nbytes > 0)
+		{
+			DbgOut(DBGERROR, "ISR(rx), nbytes > 0");
+		}
+
+		nbytes = 0;
+	}
+
+	if (nbytes == 0)
+	{
+		if (!s) {
+			DbgOut(DBGERROR, "ISR(rx), !s");
+			return;
+		}
+
+		#if defined(DATA_UART_RATE_MAX)
+		if (b & LINK_CTRL)
+		{
+			#if defined(DATA_UART_CREDIT) && defined(DATA_UART_MASTER)
+			if ((b & LINK_OP) == LINK_CREDIT)
+			{
+				g_link_limit = b & LINK_COUNT;
+				g_link_credit = 1;
+				g_link_ncredit++;
+				g_link_starved = 0;
+				uart_setUDRIE(1);
+				return;
+			}
+			#endif
+
+			#if defined(DATA_UART_CREDIT) && !defined(DATA_UART_MASTER)
+			if ((b & LINK_OP) == LINK_SYNC)
+			{
+				g_link_nrecv = b & LINK_COUNT;  // all frames the master has sent before are here or lost
+				link_credit_changed();
+				return;
+			}
+			#endif
+
+			g_link_rx = b;
+			return;
+		}
+		#endif
+
+		// a frame goes into one record, a batch frame as it is, a single message gets its size in front
+
+		uint8_t nframe = LINK_LENGTH(b) + 1;
+
+		#if defined(LINK_BATCH_RX)
+		if (b & LINK_BATCH) {
+			nframe = b & ~LINK_BATCH;
+		}
+		#endif
+
+		if (nframe == 0 || nframe > LINK_FRAME_MAX) {
+			DbgOut(DBGERROR, "ISR(rx), message size to big");
+			LINK_FRAME_DONE();
+			return;
+		}
+
+		pframe = record_prepare(g_rxfifo, nframe + 1);
+
+		if (pframe == NULL)
+		{
+			DbgOut(DBGERROR, "ISR(rx), buffer full");
+			LINK_FRAME_DONE();
+			return;
+		}
+
+		pframe[0] = nframe;
+		pdata = &pframe[1];
+		nbytes = nframe;
+
+		#if defined(LINK_BATCH_RX)
+		if (b & LINK_BATCH)
+			return;
+		#endif
+	}
+
+	// store byte
+
+	*pdata++ = b;
+	nbytes--;
+
+	// commit the message
+
+	if (nbytes == 0)
+	{
+		if (!frame_valid(pframe)) {
+			DbgOut(DBGERROR, "ISR(rx), invalid frame");
+			LINK_FRAME_DONE();
+			return;
+		}
+
+		record_push(g_rxfifo);
+		LINK_FRAME_DONE();
+
+		#if defined(DATA_UART_RATE_MAX)
+		if (++g_link_ngood >= LINK_GOOD_FRAMES)
+		{
+			g_link_ngood = 0;
+			g_link_nerrors = 0;
+		}
+		#endif
+	}
+}
+
+#endif
+
+
+#if defined(DATA_UART_RATE_MAX)
+
+static void link_send(uint8_t ctrl)
+{
+	g_link_tx = ctrl;
+	uart_setUDRIE(1);
+}
+
+static void link_set_rate(uint8_t rate)
+{
+	uart_setRate(g_link_rates[rate].ubrr, g_link_rates[rate].u2x);
+	g_link_rate = rate;
+}
+
+static void link_open(void)
+{
+	g_link_state = LINK_STATE_UP;
+	g_link_up = 1;
+
+	#if defined(DATA_UART_MASTER)
+	g_link_stable = 0;
+	g_link_t_open = clock_ms();
+	#endif
+
+	#if defined(DATA_UART_CREDIT) && defined(DATA_UART_MASTER)
+	link_send(LINK_SYNC); // the slave may have been reset, start with the same frame count
+	#elif defined(DATA_UART_CREDIT)
+	g_link_credit_tx = 1;
+	#endif
+
+	uart_setUDRIE(1); // send what was held back
+}
+
+#if defined(DATA_UART_MASTER)
+
+static void link_request(uint16_t now)
+{
+	if (g_link_rate_max == 0)
+	{
+		link_open();
+		return;
+	}
+
+	g_link_up = 0;
+	g_link_state = LINK_STATE_REQUEST;
+	g_link_retries = 0;
+	g_link_t0 = now; // the first LINK_REQ goes out after LINK_TIMEOUT_MS
+}
+
+#endif
+
+static void link_init(void)
+{
+	#if defined(DATA_UART_MASTER)
+	link_request(clock_ms());
+	#else
+	link_send(LINK_RESET); // tell a master that is still at a fast rate that we are back
+	#endif
+
+	#if defined(DATA_UART_CREDIT) && !defined(DATA_UART_MASTER)
+	link_credit_changed();
+	#endif
+}
+
+#if defined(DATA_UART_CREDIT) && defined(DATA_UART_MASTER)
+
+// called while the link is up, a master that keeps waiting for credit syncs the frame count every
+// LINK_SYNC_MS, a lost frame would otherwise shrink the window for good even if credit still comes in
+
+static void link_credit_check(uint16_t now)
+{
+	uint8_t const ncredit = g_link_ncredit;
+
+	if (ncredit != g_link_ncredit_seen)
+	{
+		g_link_ncredit_seen = ncredit;
+		g_link_retries = 0;
+	}
+
+	if (!g_link_starved)
+	{
+		g_link_t0 = now;
+		return;
+	}
+
+	if ((uint16_t)(now - g_link_t0) < LINK_SYNC_MS)
+		return;
+
+	g_link_t0 = now;
+
+	if (++g_link_retries > LINK_CHECKS)
+	{
+		DbgOut(DBGERROR, "link, no credit, flow control off");
+		g_link_credit = 0;
+		g_link_starved = 0;
+		uart_setUDRIE(1);
+		return;
+	}
+
+	link_send(LINK_SYNC);
+}
+
+#endif
+
+void comm_task(void)
+{
+	uint16_t const now = clock_ms();
+	uint8_t rx;
+	uint8_t fail;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		rx = g_link_rx;
+		fail = g_link_fail;
+		g_link_rx = 0;
+		g_link_fail = 0;
+	}
+
+	#if defined(DATA_UART_MASTER)
+
+	switch (g_link_state)
+	{
+	case LINK_STATE_UP:
+		// a slower rate is only kept while the link keeps failing soon after it came up, a link
+		// that ran well for a while (e.g. until the slave was reset) starts over at the top rate
+
+		if (!g_link_stable && (uint16_t)(now - g_link_t_open) >= LINK_STABLE_MS)
+		{
+			g_link_stable = 1;
+			g_link_rate_max = DATA_UART_RATE_MAX;
+		}
+
+		if (fail && g_link_rate > 0)
+		{
+			DbgOut(DBGERROR, "link, fall back from rate %d", g_link_rate);
+			g_link_rate_max = g_link_stable ? DATA_UART_RATE_MAX : g_link_rate - 1;
+			link_set_rate(0);
+			link_request(now);
+		}
+		else if (rx == LINK_RESET && g_link_rate == 0)
+		{
+			g_link_rate_max = DATA_UART_RATE_MAX;
+			link_request(now); // the slave was reset
+		}
+		#if defined(DATA_UART_CREDIT)
+		else
+		{
+			link_credit_check(now);
+		}
+		#endif
+		break;
+
+	case LINK_STATE_REQUEST:
+		if ((rx & LINK_OP) == LINK_ACK && (rx & LINK_RATE) <= g_link_rate_max)
+		{
+			link_set_rate(rx & LINK_RATE);
+
+			if (g_link_rate == 0)
+			{
+				link_open();
+				break;
+			}
+
+			g_link_state = LINK_STATE_SWITCH;
+			g_link_retries = 0;
+			g_link_t0 = now;
+		}
+		else if ((uint16_t)(now - g_link_t0) >= LINK_TIMEOUT_MS)
+		{
+			if (++g_link_retries > LINK_RETRIES)
+			{
+				DbgOut(DBGERROR, "link, no answer to LINK_REQ");
+				link_open(); // stay at the safe rate, e.g. with an old firmware on the other side
+				break;
+			}
+
+			link_send(LINK_REQ | g_link_rate_max);
+			g_link_t0 = now;
+		}
+		break;
+
+	case LINK_STATE_SWITCH:
+		if ((uint16_t)(now - g_link_t0) >= LINK_SETTLE_MS)
+		{
+			link_send(LINK_CHECK | g_link_rate);
+			g_link_state = LINK_STATE_CHECK;
+			g_link_t0 = now;
+		}
+		break;
+
+	case LINK_STATE_CHECK:
+		if (rx == (LINK_CHECK | g_link_rate))
+		{
+			DbgOut(DBGINFO, "link, rate %d", g_link_rate);
+			link_open();
+		}
+		else if (fail || (uint16_t)(now - g_link_t0) >= LINK_TIMEOUT_MS)
+		{
+			if (++g_link_retries < LINK_CHECKS)
+			{
+				link_send(LINK_CHECK | g_link_rate);
+				g_link_t0 = now;
+				break;
+			}
+
+			// the slave falls back on its own, the next LINK_REQ of this attempt asks for a slower rate
+
+			DbgOut(DBGERROR, "link, rate %d failed", g_link_rate);
+			g_link_rate_max = g_link_rate - 1;
+			link_set_rate(0);
+			link_request(now);
+		}
+		break;
+	}
+
+	#else
+
+	switch (g_link_state)
+	{
+	case LINK_STATE_UP:
+		if ((rx & LINK_OP) == LINK_REQ)
+		{
+			uint8_t const rate = rx & LINK_RATE;
+
+			g_link_up = 0;
+			g_link_rate_max = (rate < DATA_UART_RATE_MAX) ? rate : DATA_UART_RATE_MAX;
+			link_send(LINK_ACK | g_link_rate_max);
+			g_link_state = LINK_STATE_SWITCH;
+		}
+		else if (rx == (LINK_CHECK | g_link_rate))
+		{
+			link_send(rx); // the master did not get our echo
+		}
+		else if (fail && g_link_rate > 0)
+		{
+			DbgOut(DBGERROR, "link, fall back from rate %d", g_link_rate);
+			link_set_rate(0);
+			link_send(LINK_RESET);
+		}
+		break;
+
+	case LINK_STATE_SWITCH:
+		// switch when LINK_ACK is out, the messages are held back until then
+
+		if (g_link_tx == 0 && uart_getTXC())
+		{
+			link_set_rate(g_link_rate_max);
+
+			if (g_link_rate == 0)
+			{
+				link_open();
+				break;
+			}
+
+			g_link_state = LINK_STATE_CHECK;
+			g_link_t0 = now;
+		}
+		break;
+
+	case LINK_STATE_CHECK:
+		if (rx == (LINK_CHECK | g_link_rate))
+		{
+			link_send(rx);
+			link_open();
+		}
+		else if (fail || (uint16_t)(now - g_link_t0) >= LINK_WAIT_MS)
+		{
+			link_set_rate(0);
+			link_open();
+		}
+		break;
+	}
+
+	#endif
+}
+
+#else
+
+void comm_task(void) {}
+
+#endif
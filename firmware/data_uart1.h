@@ -1,32 +1,37 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
-
-#ifndef DATA_UART1_H__INCLUDED
-#define DATA_UART1_H__INCLUDED
-
-#include <stdint.h>
-#include <avr/io.h>
-
-static void inline uart_setUDRIE(uint8_t x) { if (x) { UCSR1B |= (1 << UDRIE1); } else { UCSR1B &= ~(1 << UDRIE1); } }
-static void inline uart_writeUDR(uint8_t x) { UDR1 = x; }
-static uint8_t inline uart_readUDR(void) { return UDR1; }
-static void inline uart_setBIT8TX(uint8_t x) { if (x) { UCSR1B |= (1 << TXB81); } else { UCSR1B &= ~(1 << TXB81); } }
-static uint8_t inline uart_getBIT8RX(void) { return UCSR1B & (1 << RXB81); }
-static uint8_t inline uart_getSRA(void) { return UCSR1A; }
-static uint8_t inline uart_getError(void) { return UCSR1A & ((1 << FE1) | (1 << DOR1) | (1 << UPE1)); }
-
-
-#endif
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DATA_UART1_H__INCLUDED
+#define DATA_UART1_H__INCLUDED
+
+#include <stdint.h>
+#include <avr/io.h>
+
+static void inline uart_setUDRIE(uint8_t x) { if (x) { UCSR1B |= (1 << UDRIE1); } else { UCSR1B &= ~(1 << UDRIE1); } }
+static void inline uart_writeUDR(uint8_t x) { UDR1 = x; }
+static uint8_t inline uart_readUDR(void) { return UDR1; }
+static void inline uart_setBIT8TX(uint8_t x) { if (x) { UCSR1B |= (1 << TXB81); } else { UCSR1B &= ~(1 << TXB81); } }
+static uint8_t inline uart_getBIT8RX(void) { return UCSR1B & (1 << RXB81); }
+static uint8_t inline uart_getSRA(void) { return UCSR1A; }
+static uint8_t inline uart_getError(void) { return UCSR1A & ((1 << FE1) | (1 << DOR1) | (1 << UPE1)); }
+static void inline uart_setRate(uint8_t ubrr, uint8_t u2x) { UBRR1 = ubrr; UCSR1A = u2x ? (1 << U2X1) : 0; }
+static void inline uart_clearTXC(void) { UCSR1A = (UCSR1A & (1 << U2X1)) | (1 << TXC1); }
+static uint8_t inline uart_getTXC(void) { return UCSR1A & (1 << TXC1); }
+
+#define UART_ERROR_FE (1 << FE1)
+
+
+#endif
@@ -1,226 +1,1834 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
- 
-#include <stdint.h>
-#include <avr/interrupt.h>
-#include <avr/io.h>
-
-#include <hwconfig.h>
-#include "led.h"
-
-
-#if !defined(LED_TIMER_vect)
-	void led_init(void) {}
-	void led_update(uint8_t *p8bytes) {}
-#else
-
-
-#define MAP(X, pin, inv) X##pin##_index,
-enum { LED_MAPPING_TABLE(MAP) NUMBER_OF_LEDS };
-#undef MAP
-
-#define NUMBER_OF_BANKS   ((NUMBER_OF_LEDS + 7) / 8)
-#define MAX_PWM 49
-
-
-#if (NUMBER_OF_LEDS > 32)
-	#error "number of led pins is bigger than 32!"
-#endif
-
-
-struct {
-	volatile uint8_t enable;
-	volatile uint8_t mode;
-} g_LED[NUMBER_OF_BANKS * 8];
-
-volatile uint16_t g_dt = 256;  // access is not atomic, but the read in the pwm loop is not critical
-
-
-static void update_state(uint8_t * p5bytes);
-static void update_profile(int8_t k, uint8_t * p8bytes);
-static void update_pwm(uint8_t *pwm, int8_t n, uint16_t t);
-static void led_ports_init(void);
-
-
-
-void led_init(void)
-{
-	/* LED driver */
-	led_ports_init();
-
-	// Timer for soft-PWM
-	led_timer_init();
-}
-
-
-void led_update(uint8_t *p8bytes)
-{
-	static uint8_t nbank = 0;
-
-	if (p8bytes[0] == 64)
-	{
-		update_state(p8bytes + 1);
-		nbank = 0;
-	}
-	else
-	{
-		update_profile(nbank, p8bytes);
-		nbank = (nbank + 1) & 0x03;
-	}
-}
-
-
-static void update_state(uint8_t * p5bytes)
-{
-	for (int8_t k = 0; k < NUMBER_OF_BANKS; k++)
-	{
-		uint8_t b = p5bytes[k];
-
-		for (int8_t i = 0; i < 8; i++)
-		{
-			g_LED[k * 8 + i].enable = b & 0x01;
-			b >>= 1;
-		}
-	}
-
-	uint8_t pulse_speed = p5bytes[4];
-
-	if (pulse_speed > 7)
-	    pulse_speed = 7;
-
-	if (pulse_speed == 0)
-	    pulse_speed = 1;
-
-	g_dt = pulse_speed * 128;
-}
-
-
-static void update_profile(int8_t k, uint8_t * p8bytes)
-{
-	if (k >= NUMBER_OF_BANKS)
-		return;
-
-	for (int8_t i = 0; i < 8; i++)
-	{
-		g_LED[k * 8 + i].mode = p8bytes[i];
-	}
-}
-
-
-static void update_pwm(uint8_t *pwm, int8_t n, uint16_t t)
-{
-	for (int8_t i = 0; i < n; i++) 
-	{
-		if (g_LED[i].enable == 0)
-		{
-			pwm[i] = 0;
-		}
-		else
-		{
-			uint8_t b = g_LED[i].mode;
-
-			if ((b >= 0) && (b <= MAX_PWM))
-			{
-				// constant brightness
-
-				pwm[i] = b;
-			}
-			else if (b == 129)
-			{
-				// triangle
-
-				uint16_t x = t >> 8;
-				if (x & 0x80) // 128..255
-					x = 255 - x;
-
-				pwm[i] = (MAX_PWM * x) >> 7;
-
-			}
-			else if (b == 130)
-			{
-				// rect
-				
-				pwm[i] = (t & 0x8000) ? MAX_PWM : 0;
-			}
-			else if (b == 131)
-			{
-				// fall
-
-				uint16_t x = 255 - (t >> 8);
-
-				pwm[i] = (MAX_PWM * x) >> 8;
-			}
-			else if (b == 132)
-			{
-				// rise
-
-				uint16_t x = t >> 8;
-
-				pwm[i] = (MAX_PWM * x) >> 8;
-			}
-			else
-			{
-				// unexpected!
-
-				pwm[i] = 0;
-			}
-		}
-	}
-}
-
-
-ISR(LED_TIMER_vect)
-{
-	#if defined(ENABLE_PROFILING)
-	profile_start();
-	#endif
-
-	static int8_t counter = 0;
-	static uint16_t t = 0;
-	static uint8_t pwm[NUMBER_OF_LEDS];
-
-	counter--;
-
-	if (counter < 0)
-	{
-		// reset counter
-		counter = MAX_PWM - 1; // pwm value of MAX_PWM should be allways 'on', 0 should be allways 'off'
-
-		// increment time counter
-		t += g_dt;
-
-		// update pwm values
-		update_pwm(pwm, sizeof(pwm) / sizeof(pwm[0]), t);
-	}
-
-	// set or clear all defined pins
-
-	#define MAP(X, pin, inv) if ((pwm[X##pin##_index] > counter) == (!inv)) { PORT##X |= (1 << pin); } else { PORT##X &= ~(1 << pin); }
-	LED_MAPPING_TABLE(MAP)
-	#undef MAP
-}
-
-
-static void led_ports_init(void)
-{
-	#define MAP(X, pin, inv) \
-		PORT##X &= ~(1 << pin); \
-		DDR##X  |= (1 << pin);
-	LED_MAPPING_TABLE(MAP)
-	#undef MAP
-}
-
-#endif
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+ 
+#include <stdint.h>
+#include <string.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+
+#include <hwconfig.h>
+#include "clock.h"
+#include "comm.h"
+#include "queue.h"
+#include "led.h"
+#include "ledseq.h"
+
+
+#if !defined(LED_TIMER_vect)
+	void led_init(void) {}
+	void led_update(uint8_t unit, uint8_t *p8bytes) {}
+	void led_update_frame(uint8_t const *pframe) {}
+	void led_update_delta(uint8_t const *pdata, uint8_t ndata) {}
+	void led_update_fade(uint8_t const *pdata, uint8_t ndata) {}
+	void led_update_timed(uint8_t const *pdata, uint8_t ndata) {}
+	void led_update_bright(uint8_t const *pdata, uint8_t ndata) {}
+	void led_update_pba(uint8_t const *pdata, uint8_t ndata) {}
+	void led_set_gamma(uint8_t gamma) {}
+	void led_set_scene(uint8_t op) {}
+	void led_set_phase(uint16_t phase) {}
+	void led_task(void) {}
+#else
+
+
+#if !defined(LED_PWM_ENGINE)
+	#define LED_PWM_ENGINE LED_PWM_TICK
+#endif
+
+#if defined(LED_SR_OUTPUTS)
+
+// the outputs are on a chain of shift registers at the SPI port (led_sr_init() in hwconfig.h),
+// LED_MAPPING_TABLE is not used for the LEDs then
+
+#define NUMBER_OF_LEDS LED_SR_OUTPUTS
+
+#if (NUMBER_OF_LEDS % 8 != 0) || (NUMBER_OF_LEDS < 8) || (NUMBER_OF_LEDS > 128)
+	#error "LED_SR_OUTPUTS must be a multiple of 8 up to 128!"
+#endif
+
+#if (LED_PWM_ENGINE != LED_PWM_BAM)
+	#error "shift register outputs need LED_PWM_ENGINE == LED_PWM_BAM"
+#endif
+
+// with LED_SR_INVERTED an output is on while the register pin is low (LEDs between VCC and the pins)
+
+#if defined(LED_SR_INVERTED)
+	#define LED_SR_IMAGE(x) ((uint8_t)~(x))
+#else
+	#define LED_SR_IMAGE(x) (x)
+#endif
+
+#else
+
+#define MAP(X, pin, inv) X##pin##_index,
+enum { LED_MAPPING_TABLE(MAP) NUMBER_OF_LEDS };
+#undef MAP
+
+#if (NUMBER_OF_LEDS > 32)
+	#error "number of led pins is bigger than 32!"
+#endif
+
+#endif
+
+#define NUMBER_OF_BANKS   ((NUMBER_OF_LEDS + 7) / 8)
+#define MAX_PWM 49
+
+
+#if !defined(LED_SR_OUTPUTS)
+
+// all ports that may carry LED pins, not every MCU has all of them
+
+#define LED_PORT_TABLE(_map_) \
+	_map_(A) _map_(B) _map_(C) _map_(D) _map_(E) _map_(F) _map_(G) _map_(H) _map_(J) _map_(K) _map_(L)
+
+#define MAP(P) LED_PORTID_##P,
+enum { LED_PORT_TABLE(MAP) };
+#undef MAP
+
+// derive the LED pins of each port from the mapping table, bits 0..7 are the pins, bits 8..15 the inverted ones
+
+#define LED_PINBITS(P, X, pin, inv) | ((LED_PORTID_##X == LED_PORTID_##P) ? (((inv) ? 0x0101u : 0x0001u) << (pin)) : 0)
+#define LED_PINBITS_A(X, pin, inv) LED_PINBITS(A, X, pin, inv)
+#define LED_PINBITS_B(X, pin, inv) LED_PINBITS(B, X, pin, inv)
+#define LED_PINBITS_C(X, pin, inv) LED_PINBITS(C, X, pin, inv)
+#define LED_PINBITS_D(X, pin, inv) LED_PINBITS(D, X, pin, inv)
+#define LED_PINBITS_E(X, pin, inv) LED_PINBITS(E, X, pin, inv)
+#define LED_PINBITS_F(X, pin, inv) LED_PINBITS(F, X, pin, inv)
+#define LED_PINBITS_G(X, pin, inv) LED_PINBITS(G, X, pin, inv)
+#define LED_PINBITS_H(X, pin, inv) LED_PINBITS(H, X, pin, inv)
+#define LED_PINBITS_J(X, pin, inv) LED_PINBITS(J, X, pin, inv)
+#define LED_PINBITS_K(X, pin, inv) LED_PINBITS(K, X, pin, inv)
+#define LED_PINBITS_L(X, pin, inv) LED_PINBITS(L, X, pin, inv)
+
+#define MAP(P) LED_PORTBITS_##P = 0 LED_MAPPING_TABLE(LED_PINBITS_##P),
+enum { LED_PORT_TABLE(MAP) };
+#undef MAP
+
+// pins that are driven by a hardware PWM channel (LED_HWPWM_TABLE in hwconfig.h) are not part of the soft-PWM
+
+#if defined(LED_HWPWM_TABLE)
+	#define LED_HWBITS(P, X, pin) | ((LED_PORTID_##X == LED_PORTID_##P) ? (1 << (pin)) : 0)
+	#define LED_HWBITS_A(X, pin, ocr, tccr, com) LED_HWBITS(A, X, pin)
+	#define LED_HWBITS_B(X, pin, ocr, tccr, com) LED_HWBITS(B, X, pin)
+	#define LED_HWBITS_C(X, pin, ocr, tccr, com) LED_HWBITS(C, X, pin)
+	#define LED_HWBITS_D(X, pin, ocr, tccr, com) LED_HWBITS(D, X, pin)
+	#define LED_HWBITS_E(X, pin, ocr, tccr, com) LED_HWBITS(E, X, pin)
+	#define LED_HWBITS_F(X, pin, ocr, tccr, com) LED_HWBITS(F, X, pin)
+	#define LED_HWBITS_G(X, pin, ocr, tccr, com) LED_HWBITS(G, X, pin)
+	#define LED_HWBITS_H(X, pin, ocr, tccr, com) LED_HWBITS(H, X, pin)
+	#define LED_HWBITS_J(X, pin, ocr, tccr, com) LED_HWBITS(J, X, pin)
+	#define LED_HWBITS_K(X, pin, ocr, tccr, com) LED_HWBITS(K, X, pin)
+	#define LED_HWBITS_L(X, pin, ocr, tccr, com) LED_HWBITS(L, X, pin)
+	#define MAP(P) LED_HWPORTBITS_##P = 0 LED_HWPWM_TABLE(LED_HWBITS_##P),
+#else
+	#define MAP(P) LED_HWPORTBITS_##P = 0,
+#endif
+enum { LED_PORT_TABLE(MAP) };
+#undef MAP
+
+#define LED_MASK(P) ((uint8_t)(LED_PORTBITS_##P & ~LED_HWPORTBITS_##P))
+#define LED_INV(P)  ((uint8_t)(LED_PORTBITS_##P >> 8) & LED_MASK(P))
+
+// give the ports that are in use consecutive slot numbers, e.g. for a per port output image
+
+#define MAP(P) LED_SLOT_##P, LED_SLOTEND_##P = LED_SLOT_##P + (LED_MASK(P) != 0) - 1,
+enum { LED_PORT_TABLE(MAP) NUMBER_OF_PORTS };
+#undef MAP
+
+#endif
+
+
+// the modes are decoded to a constant brightness 0..MAX_PWM or to one of the waveforms, the level
+// of a waveform is evaluated once per period and stored in g_wave[mode - LED_LEVEL_TRIANGLE]
+
+enum {
+	LED_LEVEL_TRIANGLE = MAX_PWM + 1,
+	LED_LEVEL_RECT,
+	LED_LEVEL_FALL,
+	LED_LEVEL_RISE,
+	LED_LEVEL_OFF,
+	NUMBER_OF_LEVELS
+};
+
+// The update functions write to a back buffer which is taken over by the PWM interrupt at the next
+// period boundary after a commit. The interrupt never sees a half written frame and works on its
+// own copy, so it does not have to use volatile accesses.
+
+// The state is kept as bit masks with one bit per output, the bytes of a mask are the banks of the
+// SBA/PBA reports (bit 0 of bank 0 is output 0).
+
+typedef struct {
+	uint8_t bank[NUMBER_OF_BANKS];
+} led_mask_t;
+
+typedef struct {
+	led_mask_t enable;                   // output is switched on
+	led_mask_t wave;                     // mode is a waveform (or 'off'), not a constant brightness
+	led_mask_t dither;                   // constant brightness with the fraction in frac[]
+	uint8_t mode[NUMBER_OF_BANKS * 8];   // brightness 0..MAX_PWM or LED_LEVEL_xxx
+	uint8_t frac[NUMBER_OF_BANKS * 8];   // fraction of the brightness in 1/256
+	uint16_t dt;                         // time increment per period, i.e. the pulse speed
+} led_state_t;
+
+static volatile led_state_t g_back = { .dt = 256 };
+static led_state_t g_front = { .dt = 256 };
+
+static volatile uint8_t g_commit = 0;  // the back buffer holds a new frame
+static volatile uint8_t g_busy = 0;    // the back buffer is being written
+static volatile uint8_t g_open = 0;    // PBA sequences that are not committed yet, see below
+
+static uint8_t g_wave[NUMBER_OF_LEVELS - LED_LEVEL_TRIANGLE];
+
+// Fades: the level of a fading output is an 8.16 fixed point value that is moved by 'step' once per
+// period, when 'n' reaches zero the output continues with its (constant) mode. The 16 fractional
+// bits keep the step of a slow fade from rounding to zero, e.g. one level in 10s is 1/1020 level
+// per period. A fade is requested
+// in g_fade_back[] and started by the interrupt together with the commit of the target state, any
+// other update of the output cancels it.
+
+#if (LED_PWM_ENGINE == LED_PWM_BAM)
+
+#define BAM_BITS 6
+
+// duration of the least significant plane in timer ticks, one period is about as long as MAX_PWM ticks
+// of 200us, rounded to the nearest tick
+
+#define BAM_UNIT_TICKS (((F_CPU / LED_TIMER_PRESCALER) / 1000L * (MAX_PWM * 200L) + (1000L * ((1 << BAM_BITS) - 1)) / 2) / (1000L * ((1 << BAM_BITS) - 1)))
+
+// the actual period of the bit planes, e.g. 9828us instead of 9800us
+
+#define LED_PERIOD_US ((BAM_UNIT_TICKS * ((1 << BAM_BITS) - 1) * LED_TIMER_PRESCALER * 1000L) / (F_CPU / 1000L))
+
+#else
+
+#define LED_PERIOD_US (MAX_PWM * 200L)
+
+#endif
+
+typedef struct {
+	uint32_t level;
+	int32_t step;
+	uint16_t n;
+} led_fade_t;
+
+// Without ENABLE_LED_FADE the masks stay empty and a fade sets its targets at once.
+
+#if defined(ENABLE_LED_FADE)
+static volatile led_fade_t g_fade_back[NUMBER_OF_BANKS * 8];
+static led_fade_t g_fade[NUMBER_OF_BANKS * 8];  // owned by the interrupt
+#endif
+
+static volatile led_mask_t g_fade_start;   // start the fade from g_fade_back[] with the next commit
+static volatile led_mask_t g_fade_cancel;  // stop the fade with the next commit
+static led_mask_t g_fading;
+
+// Dithering: the fraction of an 8 bit brightness is added to an error accumulator once per period,
+// on an overflow the output is one step brighter for that period. So the average over the periods
+// is the exact brightness, without a finer PWM step.
+
+static uint8_t g_dither_error[NUMBER_OF_BANKS * 8];  // owned by the interrupt
+
+// Gamma correction: a constant brightness 0..MAX_PWM is mapped to an 8.8 fixed point level when it
+// is received, the fraction is dithered. The curve is selected with LED_CMD_GAMMA and kept in EEPROM.
+
+static const uint16_t PROGMEM g_gamma_table[LED_GAMMA_NUMBER - 1][MAX_PWM + 1] =
+{
+	// LED_GAMMA_22, (x / 49)^2.2
+	{
+		    0,     2,    11,    27,    51,    83,   124,   173,   233,   302,
+		  380,   469,   568,   677,   797,   928,  1069,  1222,  1385,  1560,
+		 1747,  1945,  2154,  2376,  2609,  2854,  3111,  3381,  3662,  3956,
+		 4263,  4581,  4913,  5257,  5614,  5983,  6366,  6762,  7170,  7592,
+		 8027,  8475,  8936,  9411,  9899, 10401, 10916, 11445, 11988, 12544,
+	},
+	// LED_GAMMA_CIE, CIE 1976 lightness
+	{
+		    0,    28,    57,    85,   113,   145,   181,   223,   271,   326,
+		  388,   457,   533,   618,   712,   814,   926,  1047,  1179,  1321,
+		 1474,  1639,  1815,  2004,  2205,  2419,  2647,  2889,  3145,  3415,
+		 3701,  4002,  4319,  4653,  5003,  5371,  5756,  6158,  6580,  7020,
+		 7479,  7958,  8457,  8976,  9516, 10078, 10661, 11266, 11894, 12544,
+	},
+};
+
+#if (MAX_PWM != 49)
+	#error "g_gamma_table expects MAX_PWM == 49"
+#endif
+
+static uint8_t g_eeprom_gamma EEMEM = LED_GAMMA_LINEAR;
+static uint8_t g_gamma = LED_GAMMA_LINEAR;
+
+#if defined(ENABLE_LED_SCENE)
+
+// The power-on scene is a copy of the back buffer, 'size' is sizeof(led_state_t) if it is valid,
+// so a scene of a firmware with other outputs is not loaded.
+
+static struct {
+	uint16_t size;
+	led_state_t state;
+} g_eeprom_scene EEMEM = { .size = 0xFFFF };
+
+// A scene is saved from a snapshot of the back buffer, led_task() writes one byte per call and only
+// when the EEPROM is ready. A byte takes about 3.4ms, so writing the whole state at once would stall
+// USB and the main loop for up to a second. The size is cleared first and written last, a scene that
+// is cut off by a reset is not loaded.
+
+#define SCENE_STATE  2                                   // bytes 0, 1: clear the size
+#define SCENE_SIZE   (SCENE_STATE + sizeof(led_state_t)) // then the state, then the size again
+#define SCENE_END    (SCENE_SIZE + 2)
+
+static led_state_t g_scene;
+static uint16_t g_scene_pos = 0;   // next byte of the sequence above
+static uint16_t g_scene_end = 0;   // g_scene_pos == g_scene_end when idle
+
+#endif
+
+// Timed updates wait in a fifo until the interrupt finds their time reached, one chunk holds
+// [time_lo, time_hi, count, (output | LED_DELTA_ENABLE, profile) * count]
+
+#if defined(ENABLE_LED_TIMED)
+
+#define TIMED_CHUNK_LOG2   4
+#define TIMED_ENTRIES      (((1 << TIMED_CHUNK_LOG2) - 3) / 2)
+
+CREATE_FIFO(g_timedfifo, 3, TIMED_CHUNK_LOG2)
+
+#endif
+
+// Pulse timebase: the waveforms follow a phase that advances by PHASE_STEP per period, an output
+// with the pulse speed s shows the phase * s. A LED_CMD_PHASE report gives the phase the host
+// expects right now, the interrupt works off the difference over the next periods. So boards that
+// get their references from the same host clock pulse in lock-step instead of drifting apart.
+
+#define PHASE_STEP  128                  // one cycle of pulse speed 1 takes 512 periods
+#define PHASE_SLEW  (PHASE_STEP / 4)     // max. correction per period, the pulses run +-25% faster
+#define PHASE_JUMP  4096                 // a larger difference (the first reference) is taken at once
+
+static uint16_t g_phase = 0;             // owned by the interrupt
+static volatile int16_t g_phase_error = 0;
+
+
+static void update_state(uint8_t first, uint8_t const * p5bytes);
+static void update_profile(int8_t k, uint8_t const * p8bytes);
+static uint8_t decode_profile(uint8_t b);
+static uint16_t decode_level(uint8_t b);
+static void set_output(uint8_t i, uint8_t enable, uint16_t level);
+#if defined(ENABLE_LED_FADE)
+static uint16_t current_level(uint8_t i);
+#endif
+static void update_pwm(uint8_t *pwm, uint8_t n, uint16_t t);
+static void commit_state(void);
+static void timed_update(void);
+static uint16_t pulse_time(void);
+static void led_ports_init(void);
+static void led_hwpwm_init(void);
+static void led_images_init(void);
+static void update_hwpwm(uint8_t *pwm);
+static void write_hwpwm(void);
+#if !defined(LED_SR_OUTPUTS)
+static void led_ports_write(uint8_t const *pimage);
+#endif
+
+
+
+void led_init(void)
+{
+	/* LED driver */
+	led_ports_init();
+
+	// Timer for soft-PWM
+	led_timer_init();
+
+	// hardware PWM channels
+	led_hwpwm_init();
+
+	// output images of the tick and edge engines
+	led_images_init();
+
+	// gamma curve
+	g_gamma = eeprom_read_byte(&g_eeprom_gamma);
+
+	if (g_gamma >= LED_GAMMA_NUMBER) {
+		g_gamma = LED_GAMMA_LINEAR;
+	}
+
+	// the power-on scene is taken over with the first period
+
+	#if defined(ENABLE_LED_SCENE)
+	if (eeprom_read_word(&g_eeprom_scene.size) == sizeof(led_state_t))
+	{
+		led_state_t scene;
+		eeprom_read_block(&scene, &g_eeprom_scene.state, sizeof(scene));
+
+		uint8_t valid = (scene.dt >= 128 && scene.dt <= 7 * 128);
+
+		for (uint8_t i = 0; i < NUMBER_OF_BANKS * 8; i++) {
+			valid &= (scene.mode[i] < NUMBER_OF_LEVELS);
+		}
+
+		if (valid)
+		{
+			memcpy((led_state_t *)&g_back, &scene, sizeof(scene));
+			g_commit = 1;
+		}
+	}
+	#endif
+}
+
+
+// select the gamma curve for the following updates and store it in the EEPROM
+
+void led_set_gamma(uint8_t gamma)
+{
+	if (gamma >= LED_GAMMA_NUMBER)
+		return;
+
+	g_gamma = gamma;
+	eeprom_update_byte(&g_eeprom_gamma, gamma);
+}
+
+
+#if defined(ENABLE_LED_SCENE)
+
+// save the current state as the power-on scene or clear it, the EEPROM is written by led_task()
+// over the next second or so, a new request starts over
+
+void led_set_scene(uint8_t op)
+{
+	if (op == LED_SCENE_SAVE)
+	{
+		// the interrupt does not apply timed updates to the back buffer while it is busy
+
+		g_busy = 1;
+		memcpy(&g_scene, (led_state_t const *)&g_back, sizeof(g_scene));
+		g_busy = 0;
+
+		g_scene_pos = 0;
+		g_scene_end = SCENE_END;
+	}
+	else if (op == LED_SCENE_CLEAR)
+	{
+		g_scene_pos = 0;
+		g_scene_end = SCENE_STATE;
+	}
+}
+
+// called from the main loop, writes the next byte of a scene
+
+void led_task(void)
+{
+	if (g_scene_pos == g_scene_end || !eeprom_is_ready())
+		return;
+
+	uint16_t const j = g_scene_pos++;
+
+	if (j < SCENE_STATE) {
+		eeprom_update_byte((uint8_t *)&g_eeprom_scene.size + j, 0xFF);
+	} else if (j < SCENE_SIZE) {
+		eeprom_update_byte((uint8_t *)&g_eeprom_scene.state + (j - SCENE_STATE), ((uint8_t const *)&g_scene)[j - SCENE_STATE]);
+	} else {
+		eeprom_update_byte((uint8_t *)&g_eeprom_scene.size + (j - SCENE_SIZE), (uint16_t)sizeof(led_state_t) >> (8 * (j - SCENE_SIZE)));
+	}
+}
+
+#else
+
+void led_set_scene(uint8_t op) {}
+void led_task(void) {}
+
+#endif
+
+
+// discipline the pulse timebase to the phase of the host, the interrupt has advanced the phase
+// for the next period, which it prepares in advance, on average half a period ahead
+
+#define PHASE_NOW  (-PHASE_STEP / 2)   // the phase shown right now is g_phase + PHASE_NOW
+
+void led_set_phase(uint16_t phase)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		g_phase_error = (int16_t)(phase - g_phase - PHASE_NOW);
+	}
+}
+
+
+static uint8_t g_nbank[LED_UNITS]; // bank of the next PBA report of each unit
+
+// While a PBA sequence is open the back buffer holds a partial update, so timed updates are not
+// applied and committed before the sequence is complete. Bit 0..3 of g_open is set while the plain
+// PBA sequence of the unit is not at bank 0, bit 7 from a LED_CMD_PBA report without the commit
+// flag up to the next one with it.
+
+#define OPEN_PBA  0x80
+
+// an SBA report is committed at once, PBA reports when the last bank has been received
+
+void led_update(uint8_t unit, uint8_t *p8bytes)
+{
+	// the extended commands are only taken from unit 0, see led.h
+
+	if (unit > 0 && p8bytes[0] >= LED_CMD_FIRST && p8bytes[0] <= LED_CMD_LAST)
+		return;
+
+	if (p8bytes[0] == LED_CMD_DELTA)
+	{
+		led_update_delta(p8bytes, 8);
+		return;
+	}
+
+	if (p8bytes[0] == LED_CMD_FADE)
+	{
+		led_update_fade(p8bytes, 8);
+		return;
+	}
+
+	if (p8bytes[0] == LED_CMD_TIMED)
+	{
+		led_update_timed(p8bytes, 8);
+		return;
+	}
+
+	if (p8bytes[0] == LED_CMD_BRIGHT)
+	{
+		led_update_bright(p8bytes, 8);
+		return;
+	}
+
+	if (p8bytes[0] == LED_CMD_PBA)
+	{
+		led_update_pba(p8bytes, 8);
+		return;
+	}
+
+	// like the SETID command, the EEPROM commands repeat their value inverted in the last byte
+
+	uint8_t const checked =
+		p8bytes[2] == 0xFF && p8bytes[3] == 0xFF && p8bytes[4] == 0xFF &&
+		p8bytes[5] == 0xFF && p8bytes[6] == 0xFF && p8bytes[7] == (uint8_t)~p8bytes[1];
+
+	if (p8bytes[0] == LED_CMD_GAMMA)
+	{
+		if (checked) {
+			led_set_gamma(p8bytes[1]);
+		}
+
+		return;
+	}
+
+	if (p8bytes[0] == LED_CMD_SCENE)
+	{
+		if (checked) {
+			led_set_scene(p8bytes[1]);
+		}
+
+		return;
+	}
+
+	if (p8bytes[0] == LED_CMD_PHASE)
+	{
+		led_set_phase(p8bytes[LED_PHASE_VALUE] | ((uint16_t)p8bytes[LED_PHASE_VALUE + 1] << 8));
+		return;
+	}
+
+	if (p8bytes[0] == LED_CMD_SEQ)
+	{
+		ledseq_command(p8bytes);
+		return;
+	}
+
+	// SBA and PBA reports address the 32 outputs of their unit
+
+	if (unit >= LED_UNITS)
+		return;
+
+	g_busy = 1;
+
+	if (p8bytes[0] == 64)
+	{
+		update_state(unit * 4, p8bytes + 1);
+		g_nbank[unit] = 0;
+		g_commit = 1;
+	}
+	else
+	{
+		update_profile(unit * 4 + g_nbank[unit], p8bytes);
+		g_nbank[unit] = (g_nbank[unit] + 1) & 0x03;
+
+		if (g_nbank[unit] == 0) {
+			g_commit = 1;
+		}
+	}
+
+	if (g_nbank[unit] != 0) {
+		g_open |= (1 << unit);
+	} else {
+		g_open &= ~(1 << unit);
+	}
+
+	g_busy = 0;
+}
+
+
+// apply a complete LED_CMD_FRAME report
+
+void led_update_frame(uint8_t const *pframe)
+{
+	g_busy = 1;
+
+	update_state(0, pframe + LED_FRAME_STATE);
+
+	for (int8_t k = 0; k < 4; k++) {
+		update_profile(k, pframe + LED_FRAME_PROFILE + k * 8);
+	}
+
+	g_nbank[0] = 0;
+	g_open &= ~0x01;
+	g_commit = 1;
+	g_busy = 0;
+}
+
+
+// apply a LED_CMD_DELTA report of 'ndata' bytes, the PBA bank counter is not touched
+
+void led_update_delta(uint8_t const *pdata, uint8_t ndata)
+{
+	if (ndata < 2)
+		return;
+
+	uint8_t n = pdata[1];
+
+	if (n > (ndata - 2) / 2)
+		n = (ndata - 2) / 2;
+
+	g_busy = 1;
+
+	for (uint8_t k = 0; k < n; k++)
+	{
+		uint8_t const a = pdata[2 + 2 * k];
+		uint8_t const i = a & ~LED_DELTA_ENABLE;
+
+		if (i >= NUMBER_OF_BANKS * 8)
+			continue;
+
+		set_output(i, a & LED_DELTA_ENABLE, decode_level(pdata[3 + 2 * k]));
+	}
+
+	g_commit = 1;
+	g_busy = 0;
+}
+
+
+// apply a LED_CMD_FADE report of 'ndata' bytes, the outputs are switched on and fade from their
+// current level to the target brightness, a target that is a pulse mode is set without a fade
+
+void led_update_fade(uint8_t const *pdata, uint8_t ndata)
+{
+	if (ndata < LED_FADE_TARGET)
+		return;
+
+	uint8_t n = pdata[LED_FADE_COUNT];
+
+	if (n > ndata - LED_FADE_TARGET)
+		n = ndata - LED_FADE_TARGET;
+
+	#if defined(ENABLE_LED_FADE)
+	uint16_t const time_ms = pdata[LED_FADE_TIME] | ((uint16_t)pdata[LED_FADE_TIME + 1] << 8);
+	uint16_t const periods = ((uint32_t)time_ms * 1000L) / LED_PERIOD_US;
+	#endif
+
+	g_busy = 1;
+
+	for (uint8_t k = 0; k < n; k++)
+	{
+		uint8_t const i = pdata[LED_FADE_FIRST] + k;
+
+		if (i >= NUMBER_OF_BANKS * 8)
+			break;
+
+		uint16_t const target = decode_level(pdata[LED_FADE_TARGET + k]);
+
+		#if defined(ENABLE_LED_FADE)
+		uint16_t const level = current_level(i);
+
+		set_output(i, 1, target);
+
+		if ((target >> 8) > MAX_PWM || periods == 0)
+			continue;
+
+		g_fade_back[i].level = (uint32_t)level << 8;
+		g_fade_back[i].step = (((int32_t)target - (int32_t)level) << 8) / (int32_t)periods;
+		g_fade_back[i].n = periods;
+
+		uint8_t const bit = 1 << (i & 0x07);
+		g_fade_start.bank[i >> 3] |= bit;
+		g_fade_cancel.bank[i >> 3] &= ~bit;
+		#else
+		set_output(i, 1, target);
+		#endif
+	}
+
+	g_commit = 1;
+	g_busy = 0;
+}
+
+
+#if defined(ENABLE_LED_TIMED)
+
+// queue a LED_CMD_TIMED report of 'ndata' bytes, the time is an absolute clock_ms() value,
+// updates that do not fit into the fifo any more are dropped
+
+void led_update_timed(uint8_t const *pdata, uint8_t ndata)
+{
+	if (ndata < LED_TIMED_ENTRY)
+		return;
+
+	uint8_t n = pdata[LED_TIMED_COUNT];
+
+	if (n > (ndata - LED_TIMED_ENTRY) / 2)
+		n = (ndata - LED_TIMED_ENTRY) / 2;
+
+	uint8_t const time_lo = pdata[LED_TIMED_TIME];
+	uint8_t const time_hi = pdata[LED_TIMED_TIME + 1];
+
+	pdata += LED_TIMED_ENTRY;
+
+	while (n > 0)
+	{
+		uint8_t * const pchunk = chunk_prepare(g_timedfifo);
+
+		if (pchunk == NULL)
+			return;
+
+		uint8_t const k = (n > TIMED_ENTRIES) ? TIMED_ENTRIES : n;
+
+		pchunk[0] = time_lo;
+		pchunk[1] = time_hi;
+		pchunk[2] = k;
+		memcpy(&pchunk[3], pdata, 2 * k);
+
+		chunk_push(g_timedfifo);
+
+		pdata += 2 * k;
+		n -= k;
+	}
+}
+
+#else
+
+void led_update_timed(uint8_t const *pdata, uint8_t ndata) {}
+
+#endif
+
+
+// apply a LED_CMD_BRIGHT report of 'ndata' bytes, the outputs are switched on with an 8 bit brightness
+
+void led_update_bright(uint8_t const *pdata, uint8_t ndata)
+{
+	if (ndata < LED_BRIGHT_VALUE)
+		return;
+
+	uint8_t n = pdata[LED_BRIGHT_COUNT];
+
+	if (n > ndata - LED_BRIGHT_VALUE)
+		n = ndata - LED_BRIGHT_VALUE;
+
+	g_busy = 1;
+
+	for (uint8_t k = 0; k < n; k++)
+	{
+		uint8_t const i = pdata[LED_BRIGHT_FIRST] + k;
+
+		if (i >= NUMBER_OF_BANKS * 8)
+			break;
+
+		// scale 0..255 to 0..MAX_PWM as 8.8 fixed point value
+
+		uint16_t const level = ((uint32_t)pdata[LED_BRIGHT_VALUE + k] * (MAX_PWM * 256L) + 127) / 255;
+
+		set_output(i, 1, level);
+	}
+
+	g_commit = 1;
+	g_busy = 0;
+}
+
+
+// apply a LED_CMD_PBA report of 'ndata' bytes, the state and the PBA bank counter are not touched,
+// like PBA a running fade is only stopped on outputs with a new profile. The back buffer is only
+// committed with the last report of an update, like the last bank of the plain PBA sequence.
+
+void led_update_pba(uint8_t const *pdata, uint8_t ndata)
+{
+	if (ndata < LED_PBA_PROFILE)
+		return;
+
+	uint8_t n = pdata[LED_PBA_COUNT] & ~LED_PBA_COMMIT;
+
+	if (n > ndata - LED_PBA_PROFILE)
+		n = ndata - LED_PBA_PROFILE;
+
+	g_busy = 1;
+
+	for (uint8_t k = 0; k < n; k++)
+	{
+		uint8_t const i = pdata[LED_PBA_FIRST] + k;
+
+		if (i >= NUMBER_OF_BANKS * 8)
+			break;
+
+		uint16_t const level = decode_level(pdata[LED_PBA_PROFILE + k]);
+
+		if (level == (((uint16_t)g_back.mode[i] << 8) | g_back.frac[i]))
+			continue;
+
+		set_output(i, g_back.enable.bank[i >> 3] & (1 << (i & 0x07)), level);
+	}
+
+	if (pdata[LED_PBA_COUNT] & LED_PBA_COMMIT) {
+		g_open &= ~OPEN_PBA;
+		g_commit = 1;
+	} else {
+		g_open |= OPEN_PBA;
+	}
+
+	g_busy = 0;
+}
+
+
+// set state and level of a single output in the back buffer, a running fade is stopped, the level
+// is an 8.8 fixed point brightness or a LED_LEVEL_xxx waveform in the upper byte
+
+static void set_output(uint8_t i, uint8_t enable, uint16_t level)
+{
+	uint8_t const bit = 1 << (i & 0x07);
+	uint8_t const mode = level >> 8;
+	uint8_t const frac = level & 0xFF;
+
+	if (enable) {
+		g_back.enable.bank[i >> 3] |= bit;
+	} else {
+		g_back.enable.bank[i >> 3] &= ~bit;
+	}
+
+	if (mode > MAX_PWM) {
+		g_back.wave.bank[i >> 3] |= bit;
+	} else {
+		g_back.wave.bank[i >> 3] &= ~bit;
+	}
+
+	if (frac != 0) {
+		g_back.dither.bank[i >> 3] |= bit;
+	} else {
+		g_back.dither.bank[i >> 3] &= ~bit;
+	}
+
+	g_back.mode[i] = mode;
+	g_back.frac[i] = frac;
+
+	g_fade_start.bank[i >> 3] &= ~bit;
+	g_fade_cancel.bank[i >> 3] |= bit;
+}
+
+
+#if defined(ENABLE_LED_FADE)
+
+// the level an output shows right now as 8.8 fixed point value, the start of a new fade
+
+static uint16_t current_level(uint8_t i)
+{
+	uint8_t const bit = 1 << (i & 0x07);
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (g_fading.bank[i >> 3] & bit) {
+			return g_fade[i].level >> 8;
+		}
+	}
+
+	if (!(g_back.enable.bank[i >> 3] & bit)) {
+		return 0;
+	}
+
+	uint8_t const mode = g_back.mode[i];
+
+	if (mode > MAX_PWM) {
+		return (uint16_t)g_wave[mode - LED_LEVEL_TRIANGLE] << 8;
+	}
+
+	return ((uint16_t)mode << 8) | ((g_back.dither.bank[i >> 3] & bit) ? g_back.frac[i] : 0);
+}
+
+#endif
+
+
+// set the state of the banks first..first+3 and the global pulse speed
+
+static void update_state(uint8_t first, uint8_t const * p5bytes)
+{
+	for (int8_t j = 0; j < 4 && first + j < NUMBER_OF_BANKS; j++)
+	{
+		uint8_t const k = first + j;
+		uint8_t const changed = g_back.enable.bank[k] ^ p5bytes[j];
+
+		g_fade_start.bank[k] &= ~changed;
+		g_fade_cancel.bank[k] |= changed;
+
+		g_back.enable.bank[k] = p5bytes[j];
+	}
+
+	uint8_t pulse_speed = p5bytes[4];
+
+	if (pulse_speed > 7)
+	    pulse_speed = 7;
+
+	if (pulse_speed == 0)
+	    pulse_speed = 1;
+
+	g_back.dt = pulse_speed * 128;
+}
+
+
+static void update_profile(int8_t k, uint8_t const * p8bytes)
+{
+	if (k >= NUMBER_OF_BANKS)
+		return;
+
+	uint8_t wave = 0;
+	uint8_t dither = 0;
+	uint8_t changed = 0;
+
+	for (int8_t i = 0; i < 8; i++)
+	{
+		uint16_t const level = decode_level(p8bytes[i]);
+		uint8_t const mode = level >> 8;
+		uint8_t const frac = level & 0xFF;
+
+		if (mode > MAX_PWM) {
+			wave |= (1 << i);
+		}
+
+		if (frac != 0) {
+			dither |= (1 << i);
+		}
+
+		if (mode != g_back.mode[k * 8 + i] || frac != g_back.frac[k * 8 + i]) {
+			changed |= (1 << i);
+		}
+
+		g_back.mode[k * 8 + i] = mode;
+		g_back.frac[k * 8 + i] = frac;
+	}
+
+	g_back.wave.bank[k] = wave;
+	g_back.dither.bank[k] = dither;
+
+	g_fade_start.bank[k] &= ~changed;
+	g_fade_cancel.bank[k] |= changed;
+}
+
+
+// map a brightness/mode byte to a constant brightness or a LED_LEVEL_xxx waveform
+
+static uint8_t decode_profile(uint8_t b)
+{
+	if (b <= MAX_PWM) {
+		return b; // constant brightness
+	}
+
+	if (b >= 129 && b <= 132) {
+		return LED_LEVEL_TRIANGLE + (b - 129);
+	}
+
+	return LED_LEVEL_OFF; // unexpected!
+}
+
+
+// decode a brightness/mode byte to the level for set_output(), a constant brightness goes through
+// the gamma curve
+
+static uint16_t decode_level(uint8_t b)
+{
+	uint8_t const mode = decode_profile(b);
+
+	if (mode > MAX_PWM) {
+		return (uint16_t)mode << 8;
+	}
+
+	if (g_gamma == LED_GAMMA_LINEAR) {
+		return (uint16_t)mode << 8;
+	}
+
+	return pgm_read_word(&g_gamma_table[g_gamma - 1][mode]);
+}
+
+
+static void update_pwm(uint8_t *pwm, uint8_t n, uint16_t t)
+{
+	// evaluate the waveforms once for all LEDs, but only if an enabled LED uses one
+
+	uint8_t any_wave = 0;
+
+	for (uint8_t k = 0; k < NUMBER_OF_BANKS; k++) {
+		any_wave |= g_front.enable.bank[k] & g_front.wave.bank[k];
+	}
+
+	if (any_wave)
+	{
+		uint8_t x = t >> 8;
+
+		// MAX_PWM * (255 - x) is MAX_PWM * 255 - MAX_PWM * x, so one multiply does for all of them,
+		// that matters on the 32u2 which has no hardware multiplier
+
+		uint16_t const rise = MAX_PWM * (uint16_t)x;
+		uint16_t const fall = MAX_PWM * 255 - rise;
+
+		g_wave[LED_LEVEL_TRIANGLE - LED_LEVEL_TRIANGLE] = ((x & 0x80) ? fall : rise) >> 7;
+		g_wave[LED_LEVEL_RECT - LED_LEVEL_TRIANGLE] = (t & 0x8000) ? MAX_PWM : 0;
+		g_wave[LED_LEVEL_FALL - LED_LEVEL_TRIANGLE] = fall >> 8;
+		g_wave[LED_LEVEL_RISE - LED_LEVEL_TRIANGLE] = rise >> 8;
+		g_wave[LED_LEVEL_OFF - LED_LEVEL_TRIANGLE] = 0;
+	}
+
+	// walk through the masks bank by bank, disabled LEDs are 'off' and static ones need no lookup
+
+	uint8_t on = 0;
+	uint8_t wave = 0;
+	uint8_t fade = 0;
+	uint8_t dither = 0;
+
+	for (uint8_t i = 0; i < n; i++, on >>= 1, wave >>= 1, fade >>= 1, dither >>= 1)
+	{
+		if ((i & 0x07) == 0)
+		{
+			on = g_front.enable.bank[i >> 3];
+			wave = g_front.wave.bank[i >> 3] & on;
+			fade = g_fading.bank[i >> 3];
+			dither = g_front.dither.bank[i >> 3];
+		}
+
+		uint8_t b = 0;
+		uint8_t frac = 0;
+
+		#if defined(ENABLE_LED_FADE)
+		if (fade & 0x01)
+		{
+			g_fade[i].level += g_fade[i].step;
+			b = g_fade[i].level >> 16;
+			frac = g_fade[i].level >> 8;
+
+			if (--g_fade[i].n == 0) {
+				g_fading.bank[i >> 3] &= ~(1 << (i & 0x07));
+			}
+		}
+		else
+		#endif
+		if (wave & 0x01) {
+			b = g_wave[g_front.mode[i] - LED_LEVEL_TRIANGLE];
+		} else if (on & 0x01) {
+			b = g_front.mode[i];
+			frac = (dither & 0x01) ? g_front.frac[i] : 0;
+		}
+
+		// dither the fraction, one step more whenever the error accumulator overflows
+
+		if (frac != 0)
+		{
+			uint8_t const e = g_dither_error[i] + frac;
+
+			if (e < frac) {
+				b++;
+			}
+
+			g_dither_error[i] = e;
+		}
+
+		pwm[i] = b;
+	}
+}
+
+
+// called by the PWM interrupt at the start of a period
+
+static void commit_state(void)
+{
+	if (g_commit && !g_busy)
+	{
+		memcpy(&g_front, (led_state_t const *)&g_back, sizeof(g_front));
+		g_commit = 0;
+
+		// stop and start fades
+
+		for (int8_t k = 0; k < NUMBER_OF_BANKS; k++)
+		{
+			uint8_t const start = g_fade_start.bank[k];
+
+			g_fading.bank[k] = (g_fading.bank[k] & ~g_fade_cancel.bank[k]) | start;
+			g_fade_start.bank[k] = 0;
+			g_fade_cancel.bank[k] = 0;
+
+			#if defined(ENABLE_LED_FADE)
+			if (start == 0)
+				continue;
+
+			for (int8_t i = 0; i < 8; i++)
+			{
+				if (start & (1 << i)) {
+					memcpy(&g_fade[k * 8 + i], (led_fade_t const *)&g_fade_back[k * 8 + i], sizeof(led_fade_t));
+				}
+			}
+			#endif
+		}
+	}
+}
+
+
+// called by the PWM interrupt at the start of a period, advances the phase of the waveforms and
+// takes a slice of the difference to the host phase, returns the time for update_pwm()
+
+static uint16_t pulse_time(void)
+{
+	int16_t e = g_phase_error;
+
+	if (e > PHASE_JUMP || e < -PHASE_JUMP) {
+		; // take it at once
+	} else if (e > PHASE_SLEW) {
+		e = PHASE_SLEW;
+	} else if (e < -PHASE_SLEW) {
+		e = -PHASE_SLEW;
+	}
+
+	g_phase_error -= e;
+	g_phase += PHASE_STEP + e;
+
+	return g_phase * (g_front.dt / PHASE_STEP);
+}
+
+
+#if defined(ENABLE_LED_TIMED)
+
+// called by the PWM interrupt at the start of a period, applies the timed updates that are due
+// to the back buffer and commits them. Due updates wait while a PBA sequence is open.
+
+static void timed_update(void)
+{
+	uint8_t *pchunk = chunk_peek(g_timedfifo);
+
+	if (pchunk == NULL || g_busy || g_open)
+		return;
+
+	uint16_t const now = clock_ms();
+
+	while (pchunk != NULL && (int16_t)(now - (pchunk[0] | ((uint16_t)pchunk[1] << 8))) >= 0)
+	{
+		for (uint8_t k = 0; k < pchunk[2]; k++)
+		{
+			uint8_t const i = pchunk[3 + 2 * k] & ~LED_DELTA_ENABLE;
+
+			if (i < NUMBER_OF_BANKS * 8) {
+				set_output(i, pchunk[3 + 2 * k] & LED_DELTA_ENABLE, decode_level(pchunk[4 + 2 * k]));
+			}
+		}
+
+		chunk_release(g_timedfifo);
+		pchunk = chunk_peek(g_timedfifo);
+		g_commit = 1;
+	}
+}
+
+#else
+
+static void timed_update(void) {}
+
+#endif
+
+
+#if (LED_PWM_ENGINE == LED_PWM_TICK) || (LED_PWM_ENGINE == LED_PWM_EDGE)
+
+// Output images: for every counter value there is one precomputed byte per port, the pin polarity
+// is already applied. The images of the next period are built during the running period with
+// interrupts enabled, at the period boundary the ISR only switches the buffers and writes whole
+// ports. So the outputs follow a commit one period later.
+
+static uint8_t g_images[2][MAX_PWM][NUMBER_OF_PORTS];
+
+static void update_images(uint8_t images[MAX_PWM][NUMBER_OF_PORTS], uint8_t const *pwm)
+{
+	memset(images, 0x00, MAX_PWM * NUMBER_OF_PORTS);
+
+	// a pin is 'on' while pwm > counter, mark the last counter value for which it is 'on'
+
+	#define MAP(X, pin, inv) { \
+		uint8_t const b = pwm[X##pin##_index]; \
+		if (b > 0) { images[b - 1][LED_SLOT_##X] |= (1 << pin); } \
+	}
+	LED_MAPPING_TABLE(MAP)
+	#undef MAP
+
+	// then it is also 'on' for all smaller counter values
+
+	#define MAP(P) if (LED_MASK(P) != 0) { \
+		uint8_t x = 0; \
+		for (int8_t c = MAX_PWM - 1; c >= 0; c--) { \
+			x |= images[c][LED_SLOT_##P]; \
+			images[c][LED_SLOT_##P] = x ^ LED_INV(P); \
+		} \
+	}
+	LED_PORT_TABLE(MAP)
+	#undef MAP
+}
+
+// both buffers start with all outputs off
+
+static void led_images_init(void)
+{
+	uint8_t const pwm[NUMBER_OF_LEDS] = { 0 };
+
+	update_images(g_images[0], pwm);
+	update_images(g_images[1], pwm);
+}
+
+#elif defined(LED_SR_OUTPUTS)
+
+static void led_images_init(void) {}
+
+#endif
+
+
+#if (LED_PWM_ENGINE == LED_PWM_BAM)
+
+// Bit angle modulation: the pwm value is split into binary weighted bit planes and every plane is
+// shown for a time that is proportional to its weight. The port images of the planes are computed
+// once per period, so the ISR only has to write a few whole ports at the start of each plane.
+
+// planes that do not fit into one timer cycle are shown for several cycles of (BAM_UNIT_TICKS << BAM_SPLIT) ticks
+
+#define BAM_SPLIT ( \
+	((BAM_UNIT_TICKS << 5) <= 256) ? 5 : \
+	((BAM_UNIT_TICKS << 4) <= 256) ? 4 : \
+	((BAM_UNIT_TICKS << 3) <= 256) ? 3 : \
+	((BAM_UNIT_TICKS << 2) <= 256) ? 2 : \
+	((BAM_UNIT_TICKS << 1) <= 256) ? 1 : 0)
+
+#if (BAM_UNIT_TICKS < 8) || (BAM_UNIT_TICKS > 256)
+	#error "invalid LED timer configuration for bit angle modulation"
+#endif
+
+#if (MAX_PWM != 49)
+	#error "bam_level() expects MAX_PWM == 49"
+#endif
+
+// map 0..MAX_PWM to 0..63, that is round(x * 63 / 49)
+
+static inline uint8_t bam_level(uint8_t x)
+{
+	return ((uint16_t)x * 329 + 116) >> 8;
+}
+
+#if !defined(LED_SR_OUTPUTS)
+
+// The planes of the next period are built while the most significant plane of the running one is
+// shown, like the images of the tick engine.
+
+static uint8_t g_planes[2][BAM_BITS][NUMBER_OF_PORTS];
+
+static void update_planes(uint8_t planes[BAM_BITS][NUMBER_OF_PORTS], uint8_t const *pwm)
+{
+	// start with all pins 'off', i.e. with the inverted pins set
+
+	for (int8_t k = 0; k < BAM_BITS; k++)
+	{
+		#define MAP(P) if (LED_MASK(P) != 0) { planes[k][LED_SLOT_##P] = LED_INV(P); }
+		LED_PORT_TABLE(MAP)
+		#undef MAP
+	}
+
+	// toggle the pins that are 'on' in a plane
+
+	#define MAP(X, pin, inv) { \
+		uint8_t b = bam_level(pwm[X##pin##_index]); \
+		for (int8_t k = 0; k < BAM_BITS; k++, b >>= 1) { \
+			if (b & 0x01) { planes[k][LED_SLOT_##X] ^= (1 << pin); } \
+		} \
+	}
+	LED_MAPPING_TABLE(MAP)
+	#undef MAP
+}
+
+// both buffers start with all outputs off
+
+static void led_images_init(void)
+{
+	uint8_t const pwm[NUMBER_OF_LEDS] = { 0 };
+
+	update_planes(g_planes[0], pwm);
+	update_planes(g_planes[1], pwm);
+}
+
+// the interrupt runs with interrupts enabled, the UART and USB interrupts are only held off by
+// its entry, see the tick engine
+
+ISR(LED_TIMER_vect, ISR_NOBLOCK)
+{
+	#if defined(ENABLE_PROFILING)
+	profile_start();
+	uint16_t const t_isr = CLOCK_TCNT;
+	#endif
+
+	static int8_t plane = 0;
+	static uint8_t ncycles = 0;
+	static uint8_t front = 0;
+	static uint8_t busy = 0;
+	static uint8_t pwm[NUMBER_OF_LEDS];
+
+	// is the current plane still active? the last plane is extended if the next period is not ready
+
+	if (ncycles > 1 || (plane == 0 && busy))
+	{
+		if (ncycles > 1)
+			ncycles--;
+
+		return;
+	}
+
+	plane--;
+
+	uint8_t const prepare = (plane < 0);
+
+	if (prepare)
+	{
+		// start with the most significant plane of the planes prepared during the last period
+		plane = BAM_BITS - 1;
+		front ^= 1;
+		write_hwpwm();
+	}
+
+	// set the pins of the new plane and program its duration
+
+	led_ports_write(&g_planes[front][plane][0]);
+
+	if (plane > BAM_SPLIT)
+	{
+		ncycles = 1 << (plane - BAM_SPLIT);
+		LED_TIMER_OCR = (BAM_UNIT_TICKS << BAM_SPLIT) - 1;
+	}
+	else
+	{
+		ncycles = 1;
+		LED_TIMER_OCR = (BAM_UNIT_TICKS << plane) - 1;
+	}
+
+	// prepare the next period, together with the timed updates that are due, the following
+	// planes of the running period are nested interrupts
+
+	if (prepare)
+	{
+		timed_update();
+
+		busy = 1;
+
+		commit_state();
+		uint16_t const t = pulse_time();
+		update_pwm(pwm, sizeof(pwm) / sizeof(pwm[0]), t);
+		update_hwpwm(pwm);
+		update_planes(g_planes[front ^ 1], pwm);
+
+		busy = 0;
+	}
+
+	#if defined(ENABLE_PROFILING)
+	profile_isr((uint16_t)(CLOCK_TCNT - t_isr));
+	#endif
+}
+
+#else
+
+// With the shift register chain the next plane is clocked out by the SPI while the current one is
+// shown, the ISR only has to pulse the latch at the start of a plane. The planes are shown in
+// ascending order, the next period is prepared during the most significant plane. The interrupt
+// runs with interrupts enabled, like with the tick engine.
+
+static void update_planes(uint8_t planes[BAM_BITS][NUMBER_OF_BANKS], uint8_t const *pwm)
+{
+	memset(planes, 0x00, BAM_BITS * NUMBER_OF_BANKS);
+
+	// the byte for the last register of the chain is shifted out first, MSB first, so that
+	// output i ends up at Q(i & 7) of register (i >> 3)
+
+	for (uint8_t i = 0; i < NUMBER_OF_LEDS; i++)
+	{
+		uint8_t b = bam_level(pwm[i]);
+		uint8_t * const p = &planes[0][NUMBER_OF_BANKS - 1 - (i >> 3)];
+		uint8_t const bit = 1 << (i & 0x07);
+
+		for (int8_t k = 0; b != 0; k++, b >>= 1) {
+			if (b & 0x01) { p[k * NUMBER_OF_BANKS] |= bit; }
+		}
+	}
+}
+
+static inline void led_sr_write(uint8_t const *pplane)
+{
+	for (uint8_t k = 0; k < NUMBER_OF_BANKS; k++)
+	{
+		SPDR = LED_SR_IMAGE(pplane[k]);
+		while (!(SPSR & (1 << SPIF))) {;}
+	}
+}
+
+ISR(LED_TIMER_vect, ISR_NOBLOCK)
+{
+	#if defined(ENABLE_PROFILING)
+	profile_start();
+	uint16_t const t_isr = CLOCK_TCNT;
+	#endif
+
+	static int8_t plane = BAM_BITS - 1;
+	static uint8_t ncycles = 0;
+	static uint8_t busy = 0;
+	static uint8_t pwm[NUMBER_OF_LEDS];
+	static uint8_t planes[BAM_BITS][NUMBER_OF_BANKS];
+
+	// is the current plane still active? the last plane is extended if the next period is not ready
+
+	if (ncycles > 1 || busy)
+	{
+		if (ncycles > 1)
+			ncycles--;
+
+		return;
+	}
+
+	// show the plane that is already in the registers and program its duration
+
+	led_sr_latch();
+
+	plane = (plane < BAM_BITS - 1) ? plane + 1 : 0;
+
+	if (plane > BAM_SPLIT)
+	{
+		ncycles = 1 << (plane - BAM_SPLIT);
+		LED_TIMER_OCR = (BAM_UNIT_TICKS << BAM_SPLIT) - 1;
+	}
+	else
+	{
+		ncycles = 1;
+		LED_TIMER_OCR = (BAM_UNIT_TICKS << plane) - 1;
+	}
+
+	if (plane < BAM_BITS - 1)
+	{
+		led_sr_write(&planes[plane + 1][0]);
+		return;
+	}
+
+	// a due timed update is committed here and shown with the next period, the planes
+	// of the running period are already in the registers
+
+	timed_update();
+
+	busy = 1;
+
+	commit_state();
+	uint16_t const t = pulse_time();
+	update_pwm(pwm, sizeof(pwm) / sizeof(pwm[0]), t);
+	update_hwpwm(pwm);
+	write_hwpwm();
+	update_planes(planes, pwm);
+
+	// the first plane has to be in the registers before a (late) latch
+
+	led_sr_write(&planes[0][0]);
+
+	busy = 0;
+
+	#if defined(ENABLE_PROFILING)
+	profile_isr((uint16_t)(CLOCK_TCNT - t_isr));
+	#endif
+}
+
+#endif
+
+#elif (LED_PWM_ENGINE == LED_PWM_EDGE)
+
+// Edge scheduling: the same output images as for the tick engine are used, but the timer is programmed
+// to fire only at the counter values where at least one pin changes. Pins with a pwm value of 0 or
+// MAX_PWM never change within a period, so static scenes need only a few interrupts per period.
+
+// timer ticks per counter step (200us) and the number of steps that fit into one timer cycle
+
+#define EDGE_STEP_TICKS ((F_CPU / LED_TIMER_PRESCALER) / 1000L * 200L / 1000L)
+#define EDGE_MAX_STEPS  (256 / EDGE_STEP_TICKS)
+
+#if (EDGE_MAX_STEPS < 1)
+	#error "invalid LED timer configuration for edge scheduling"
+#endif
+
+// build the sorted list of the counter values where pins are switched on, returns the number of entries
+
+static uint8_t update_edges(uint8_t *edges, uint8_t const *pwm)
+{
+	uint8_t used[(MAX_PWM + 7) / 8];
+	memset(used, 0x00, sizeof(used));
+
+	for (int8_t i = 0; i < NUMBER_OF_LEDS; i++)
+	{
+		uint8_t const b = pwm[i];
+
+		if (b > 0 && b < MAX_PWM) {
+			used[b >> 3] |= (1 << (b & 0x07));
+		}
+	}
+
+	uint8_t n = 0;
+
+	for (uint8_t b = MAX_PWM - 1; b > 0; b--)
+	{
+		if (used[b >> 3] & (1 << (b & 0x07))) {
+			edges[n++] = b - 1;
+		}
+	}
+
+	return n;
+}
+
+ISR(LED_TIMER_vect, ISR_NOBLOCK)
+{
+	#if defined(ENABLE_PROFILING)
+	profile_start();
+	uint16_t const t_isr = CLOCK_TCNT;
+	#endif
+
+	static int8_t counter = 0;
+	static uint8_t nsteps = 0;
+	static uint8_t iedge = 0;
+	static uint8_t front = 0;
+	static uint8_t busy = 0;
+	static uint8_t pwm[NUMBER_OF_LEDS];
+	static uint8_t nedges[2];
+	static uint8_t edges[2][MAX_PWM];
+
+	uint8_t prepare = 0;
+
+	// the last step is extended if the next period is not ready yet
+
+	if (nsteps == 0 && iedge >= nedges[front] && busy) {
+		nsteps = 1;
+	}
+
+	// did we reach the next edge?
+
+	if (nsteps == 0)
+	{
+		if (iedge < nedges[front])
+		{
+			counter = edges[front][iedge++];
+		}
+		else
+		{
+			// start of a new period with the images and edges prepared during the last one
+			counter = MAX_PWM - 1;
+			front ^= 1;
+			iedge = 0;
+			write_hwpwm();
+			prepare = 1;
+		}
+
+		led_ports_write(&g_images[front][counter][0]);
+
+		nsteps = (iedge < nedges[front]) ? (counter - edges[front][iedge]) : (counter + 1);
+	}
+
+	// program the timer for the next edge, long gaps are split into several timer cycles
+
+	uint8_t const n = (nsteps > EDGE_MAX_STEPS) ? EDGE_MAX_STEPS : nsteps;
+	nsteps -= n;
+
+	uint8_t ocr = n * EDGE_STEP_TICKS - 1;
+
+	ATOMIC_BLOCK(ATOMIC_FORCEON)
+	{
+		if (LED_TIMER_TCNT >= ocr) {
+			ocr = LED_TIMER_TCNT + 1; // we are late, do not miss the compare match
+		}
+
+		LED_TIMER_OCR = ocr;
+	}
+
+	// prepare the next period, the edges of the running period are served by nested interrupts
+
+	if (prepare)
+	{
+		// a due timed update is committed here and shown with the next period
+		timed_update();
+
+		busy = 1;
+
+		commit_state();
+		uint16_t const t = pulse_time();
+		update_pwm(pwm, sizeof(pwm) / sizeof(pwm[0]), t);
+		update_hwpwm(pwm);
+		update_images(g_images[front ^ 1], pwm);
+		nedges[front ^ 1] = update_edges(edges[front ^ 1], pwm);
+
+		busy = 0;
+	}
+
+	#if defined(ENABLE_PROFILING)
+	profile_isr((uint16_t)(CLOCK_TCNT - t_isr));
+	#endif
+}
+
+#endif
+
+#if (LED_PWM_ENGINE == LED_PWM_TICK)
+
+// The interrupt runs with interrupts enabled (ISR_NOBLOCK), so the UART and USB interrupts are only
+// held off by its entry. Writing all ports of the m2560 takes longer than a byte of the link at
+// 2 MBit/s, so a blocking tick could overrun the UART. The next tick is 200us later, only the
+// preparation of the next period is long enough to see nested ticks.
+
+ISR(LED_TIMER_vect, ISR_NOBLOCK)
+{
+	#if defined(ENABLE_PROFILING)
+	profile_start();
+	uint16_t const t_isr = CLOCK_TCNT;
+	#endif
+
+	static int8_t counter = 0;
+	static uint8_t front = 0;
+	static uint8_t busy = 0;
+	static uint8_t pwm[NUMBER_OF_LEDS];
+
+	// the last step is extended if the next period is not ready yet
+
+	if (counter == 0 && busy)
+		return;
+
+	counter--;
+
+	if (counter < 0)
+	{
+		// reset counter
+		counter = MAX_PWM - 1; // pwm value of MAX_PWM should be allways 'on', 0 should be allways 'off'
+
+		// show the images prepared during the last period
+		front ^= 1;
+		write_hwpwm();
+	}
+
+	// set or clear all defined pins
+
+	led_ports_write(&g_images[front][counter][0]);
+
+	// prepare the next period, the following ticks of the running period are nested interrupts
+
+	if (counter == MAX_PWM - 1)
+	{
+		// a due timed update is committed here and shown with the next period
+		timed_update();
+
+		busy = 1;
+
+		commit_state();
+		uint16_t const t = pulse_time();
+		update_pwm(pwm, sizeof(pwm) / sizeof(pwm[0]), t);
+		update_hwpwm(pwm);
+		update_images(g_images[front ^ 1], pwm);
+
+		busy = 0;
+	}
+
+	#if defined(ENABLE_PROFILING)
+	profile_isr((uint16_t)(CLOCK_TCNT - t_isr));
+	#endif
+}
+
+#endif
+
+
+#if defined(LED_SR_OUTPUTS)
+
+static void led_ports_init(void)
+{
+	led_sr_init();
+}
+
+#else
+
+static void led_ports_init(void)
+{
+	#define MAP(X, pin, inv) \
+		PORT##X &= ~(1 << pin); \
+		DDR##X  |= (1 << pin);
+	LED_MAPPING_TABLE(MAP)
+	#undef MAP
+}
+
+#endif
+
+
+#if defined(LED_HWPWM_TABLE) && !defined(LED_SR_OUTPUTS)
+
+typedef struct {
+	uint8_t pinid;          // port id * 8 + pin
+	volatile void *ocr;     // compare register
+	uint8_t wide;           // the compare register is a 16-bit register
+	volatile uint8_t *tccr; // register of the compare output mode bits
+	uint8_t com;            // bits that connect the channel to the pin
+} hwpwm_channel_t;
+
+#define MAP(X, pin, ocr, tccr, com) { LED_PORTID_##X * 8 + (pin), &(ocr), sizeof(ocr) == 2, &(tccr), (com) },
+static const hwpwm_channel_t g_hwpwm_channel[] = { LED_HWPWM_TABLE(MAP) };
+#undef MAP
+
+#define NUMBER_OF_HWPWM (sizeof(g_hwpwm_channel) / sizeof(g_hwpwm_channel[0]))
+
+// 16-bit compare registers are written as a whole, a write of the low byte alone would take the
+// high byte from the shared TEMP register of the timer
+
+static inline void hwpwm_write(hwpwm_channel_t const *pch, uint8_t x)
+{
+	if (pch->wide) {
+		*(volatile uint16_t *)pch->ocr = x;
+	} else {
+		*(volatile uint8_t *)pch->ocr = x;
+	}
+}
+
+static struct {
+	uint8_t led; // index of the LED that is driven by the channel, 0xFF if the pin is not an LED output
+	uint8_t inv;
+	uint8_t x;   // compare value of the next period
+} g_hwpwm[NUMBER_OF_HWPWM];
+
+static void led_hwpwm_init(void)
+{
+	led_hwpwm_timer_init();
+
+	for (uint8_t k = 0; k < NUMBER_OF_HWPWM; k++)
+	{
+		hwpwm_channel_t const *pch = &g_hwpwm_channel[k];
+		uint8_t i = 0;
+
+		g_hwpwm[k].led = 0xFF;
+
+		#define MAP(X, pin, invert) \
+			if (pch->pinid == LED_PORTID_##X * 8 + (pin)) { g_hwpwm[k].led = i; g_hwpwm[k].inv = (invert); } \
+			i++;
+		LED_MAPPING_TABLE(MAP)
+		#undef MAP
+
+		if (g_hwpwm[k].led != 0xFF)
+		{
+			g_hwpwm[k].x = g_hwpwm[k].inv ? 0xFF : 0x00;
+			hwpwm_write(pch, g_hwpwm[k].x);
+			*pch->tccr |= pch->com;
+		}
+	}
+}
+
+// called once per period with the new pwm values, takes out the outputs of the channels
+
+static void update_hwpwm(uint8_t *pwm)
+{
+	for (uint8_t k = 0; k < NUMBER_OF_HWPWM; k++)
+	{
+		uint8_t const i = g_hwpwm[k].led;
+
+		if (i == 0xFF)
+			continue;
+
+		// map 0..MAX_PWM to 0..255
+		uint8_t const x = ((uint16_t)pwm[i] * ((255L * 256 + MAX_PWM - 1) / MAX_PWM)) >> 8;
+
+		g_hwpwm[k].x = g_hwpwm[k].inv ? ~x : x;
+
+		// the soft-PWM must not see an edge for this pin
+		pwm[i] = 0;
+	}
+}
+
+// called at the start of the period, the compare registers are double buffered so the update is glitch-free
+
+static void write_hwpwm(void)
+{
+	for (uint8_t k = 0; k < NUMBER_OF_HWPWM; k++)
+	{
+		if (g_hwpwm[k].led != 0xFF) {
+			hwpwm_write(&g_hwpwm_channel[k], g_hwpwm[k].x);
+		}
+	}
+}
+
+#else
+
+static void led_hwpwm_init(void) {}
+static void update_hwpwm(uint8_t *pwm) {}
+static void write_hwpwm(void) {}
+
+#endif
+
+
+#if !defined(LED_SR_OUTPUTS)
+
+// write one byte per port, 'pimage' is indexed by the port slot and must not have bits outside of the LED pins
+
+#define LED_PORT_WRITE(P, pimage) \
+	if (LED_MASK(P) != 0) { PORT##P = (PORT##P & ~LED_MASK(P)) | (pimage)[LED_SLOT_##P]; }
+
+static inline void led_ports_write(uint8_t const *pimage)
+{
+	#if defined(PORTA)
+	LED_PORT_WRITE(A, pimage)
+	#endif
+	#if defined(PORTB)
+	LED_PORT_WRITE(B, pimage)
+	#endif
+	#if defined(PORTC)
+	LED_PORT_WRITE(C, pimage)
+	#endif
+	#if defined(PORTD)
+	LED_PORT_WRITE(D, pimage)
+	#endif
+	#if defined(PORTE)
+	LED_PORT_WRITE(E, pimage)
+	#endif
+	#if defined(PORTF)
+	LED_PORT_WRITE(F, pimage)
+	#endif
+	#if defined(PORTG)
+	LED_PORT_WRITE(G, pimage)
+	#endif
+	#if defined(PORTH)
+	LED_PORT_WRITE(H, pimage)
+	#endif
+	#if defined(PORTJ)
+	LED_PORT_WRITE(J, pimage)
+	#endif
+	#if defined(PORTK)
+	LED_PORT_WRITE(K, pimage)
+	#endif
+	#if defined(PORTL)
+	LED_PORT_WRITE(L, pimage)
+	#endif
+}
+
+#endif
+
+#endif
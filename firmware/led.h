@@ -1,27 +1,155 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
-
-#ifndef LWCLONE_LED_H__INCLUDED
-#define LWCLONE_LED_H__INCLUDED
-
-#include <stdint.h>
-
-void led_init(void);
-void led_update(uint8_t *p8bytes);
-
-
-
-#endif
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LWCLONE_LED_H__INCLUDED
+#define LWCLONE_LED_H__INCLUDED
+
+#include <stdint.h>
+
+
+// soft-PWM engines, select one with LED_PWM_ENGINE in devconfig.h
+
+#define LED_PWM_TICK   0   // fixed 200us tick, precomputed port images are written on every tick (default)
+#define LED_PWM_BAM    1   // bit angle modulation, whole ports are written once per bit plane
+#define LED_PWM_EDGE   2   // the timer is programmed to fire only at the steps where a pin changes
+
+// The outputs can be split into up to 4 LedWiz units with consecutive IDs (LED_UNITS in devconfig.h),
+// unit u has the outputs u*32..u*32+31. Each unit is a top-level collection of the LED interface with
+// the report ID u+1, the SBA/PBA reports address the outputs of their unit. The extended commands are
+// only taken from unit 0 (and the misc interface), they address all outputs of the board with the
+// plain output numbers 0..127. On the other units they are ignored, so an output number is never
+// read relative to one unit on one path and to the board on another.
+
+#if !defined(LED_UNITS)
+	#define LED_UNITS 1
+#endif
+
+#if (LED_UNITS < 1) || (LED_UNITS > 4)
+	#error "LED_UNITS must be 1..4"
+#endif
+
+
+// extended commands, identified by the first byte of a report (64 is SBA, 65 and 66 are config commands).
+// LED_CMD_TIMED, LED_CMD_FADE, LED_CMD_SEQ and LED_CMD_SCENE are only built with ENABLE_LED_TIMED,
+// ENABLE_LED_FADE, ENABLE_LED_SEQUENCER and ENABLE_LED_SCENE in devconfig.h, otherwise they are
+// ignored, a fade sets its targets at once.
+
+#define LED_CMD_FRAME  67   // state, pulse speed and the profiles of all outputs at once
+#define LED_CMD_DELTA  68   // state and profile of single outputs
+#define LED_CMD_SEQ    69   // keyframe sequencer, see ledseq.h
+#define LED_CMD_FADE   70   // fade outputs to a new brightness
+#define LED_CMD_TIMED  71   // state and profile of single outputs, applied at a given device time
+#define LED_CMD_CLOCK  72   // device clock, first byte of the misc interface input report
+#define LED_CMD_BRIGHT 73   // 8 bit brightness of outputs, dithered over the PWM periods
+#define LED_CMD_GAMMA  74   // select the gamma curve: [LED_CMD_GAMMA, curve, 0xFF x 5, ~curve]
+#define LED_CMD_SCENE  75   // power-on scene: [LED_CMD_SCENE, op, 0xFF x 5, ~op]
+#define LED_CMD_PBA    76   // profiles of outputs like PBA, with an explicit output index
+#define LED_CMD_PHASE  77   // phase reference of the pulse modes: [LED_CMD_PHASE, phase_lo, phase_hi]
+
+#define LED_CMD_FIRST  LED_CMD_FRAME
+#define LED_CMD_LAST   LED_CMD_PHASE
+
+// layout of a LED_CMD_FRAME report
+
+#define LED_FRAME_STATE   1   // 4 bytes, on/off state of bank 0..3
+#define LED_FRAME_SPEED   5   // global pulse speed
+#define LED_FRAME_PROFILE 6   // 32 bytes, brightness/mode of output 1..32
+#define LED_FRAME_SIZE    38
+
+// layout of a LED_CMD_DELTA report: [LED_CMD_DELTA, count, (output | LED_DELTA_ENABLE, profile) * count],
+// an 8 byte report carries up to 3 entries
+
+#define LED_DELTA_ENABLE  0x80
+
+// layout of a LED_CMD_FADE report, the outputs first..first+count-1 fade to their targets, an 8 byte
+// report carries up to 3 targets, a 64 byte report all 32
+
+#define LED_FADE_TIME     1   // 2 bytes, duration in ms (little endian)
+#define LED_FADE_FIRST    3   // first output
+#define LED_FADE_COUNT    4   // number of targets
+#define LED_FADE_TARGET   5   // brightness/mode of the outputs, like PBA
+
+// layout of a LED_CMD_TIMED report: [LED_CMD_TIMED, time_lo, time_hi, count, entries like LED_CMD_DELTA],
+// the time is a clock_ms() value of the device (of the USB controller on boards with two controllers),
+// an 8 byte report carries up to 2 entries. The device takes over the due updates at the start of
+// a PWM period, so an update is shown up to two periods (about 20ms) after its time. A due update
+// waits while a PBA sequence (plain or LED_CMD_PBA) is not complete, so it is never shown together
+// with half of the sequence.
+
+#define LED_TIMED_TIME    1
+#define LED_TIMED_COUNT   3
+#define LED_TIMED_ENTRY   4
+
+// layout of a LED_CMD_BRIGHT report: [LED_CMD_BRIGHT, first, count, brightness * count], the outputs
+// are switched on with a brightness of 0..255, an 8 byte report carries up to 5 values, a 64 byte report all 32
+
+#define LED_BRIGHT_FIRST  1
+#define LED_BRIGHT_COUNT  2
+#define LED_BRIGHT_VALUE  3
+
+// layout of a LED_CMD_PBA report: [LED_CMD_PBA, first, count, profile * count], unlike a plain PBA
+// report it does not depend on the bank counter of the SBA/PBA sequence, so a lost or reordered report
+// can not shift the following ones, an 8 byte report carries up to 5 profiles, a 64 byte report all 32.
+// The profiles are shown once a report with LED_PBA_COMMIT in the count byte arrives, so an update
+// that is split into several reports sets it only in the last one.
+
+#define LED_PBA_FIRST     1
+#define LED_PBA_COUNT     2
+#define LED_PBA_PROFILE   3
+#define LED_PBA_COMMIT    0x80
+
+// The pulse modes follow a 16 bit phase that advances by 128 every 9.8ms period (MAX_PWM * 200us),
+// an output with pulse speed s shows phase * s. The host sends its own phase from time to time, the
+// device slews its phase towards it, so several boards pulse in step. Without references the boards
+// free-run as before.
+
+#define LED_PHASE_VALUE   1   // 2 bytes, phase (little endian)
+
+// gamma curves for the constant brightness values 0..49 of PBA, frame, delta, timed and fade updates
+
+#define LED_GAMMA_LINEAR  0
+#define LED_GAMMA_22      1   // power law, gamma 2.2
+#define LED_GAMMA_CIE     2   // CIE 1976 lightness
+#define LED_GAMMA_NUMBER  3
+
+// operations of LED_CMD_SCENE, the saved state and pulse modes of all outputs are shown from reset on,
+// before the host has even enumerated the device
+
+#define LED_SCENE_CLEAR   0   // start dark again
+#define LED_SCENE_SAVE    1   // save the current state to the EEPROM
+
+// layout of the LED_CMD_CLOCK input report, read with a GET_REPORT request on the misc interface
+
+#define LED_CLOCK_MS      1   // 2 bytes, clock_ms()
+#define LED_CLOCK_TICKS   3   // 4 bytes, clock() in F_CPU cycles
+
+
+void led_init(void);
+void led_update(uint8_t unit, uint8_t *p8bytes);
+void led_update_frame(uint8_t const *pframe);
+void led_update_delta(uint8_t const *pdata, uint8_t ndata);
+void led_update_fade(uint8_t const *pdata, uint8_t ndata);
+void led_update_timed(uint8_t const *pdata, uint8_t ndata);
+void led_update_bright(uint8_t const *pdata, uint8_t ndata);
+void led_update_pba(uint8_t const *pdata, uint8_t ndata);
+void led_set_gamma(uint8_t gamma);
+void led_set_scene(uint8_t op);
+void led_set_phase(uint16_t phase);
+void led_task(void);
+
+
+
+#endif
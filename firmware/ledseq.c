@@ -0,0 +1,243 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#include <hwconfig.h>
+#include "clock.h"
+#include "led.h"
+#include "ledseq.h"
+
+
+#if !defined(LED_TIMER_vect) || !defined(ENABLE_LED_SEQUENCER)
+	void ledseq_command(uint8_t const *p8bytes) {}
+	void ledseq_task(void) {}
+#else
+
+
+// the bank masks of the commands address the first 32 outputs
+
+#if defined(LED_SR_OUTPUTS)
+	#define NUMBER_OF_LEDS ((LED_SR_OUTPUTS < 32) ? LED_SR_OUTPUTS : 32)
+#else
+	#define MAP(X, pin, inv) X##pin##_index,
+	enum { LED_MAPPING_TABLE(MAP) NUMBER_OF_LEDS };
+	#undef MAP
+#endif
+
+
+typedef struct {
+	uint8_t profile;
+	uint16_t time_ms;
+} keyframe_t;
+
+static struct {
+	uint8_t length;
+	uint8_t loop;
+	keyframe_t key[LEDSEQ_KEYFRAMES];
+} g_program[LEDSEQ_PROGRAMS];
+
+static struct {
+	uint8_t program;  // program + 1, 0 if the output is not sequenced
+	uint8_t key;      // current keyframe
+	uint16_t remain;  // ms until the next keyframe
+} g_run[NUMBER_OF_LEDS];
+
+static uint16_t g_last_ms = 0;
+
+
+static uint16_t key_time(uint8_t program, uint8_t key)
+{
+	uint16_t const t = g_program[program].key[key].time_ms;
+
+	return (t > 0) ? t : 1;
+}
+
+// step to the next keyframe, returns 0 if the end of a program without loop is reached
+
+static uint8_t next_key(uint8_t i)
+{
+	uint8_t const program = g_run[i].program - 1;
+	uint8_t key = g_run[i].key + 1;
+
+	if (key >= g_program[program].length)
+	{
+		if (g_program[program].loop >= g_program[program].length) {
+			return 0;
+		}
+
+		key = g_program[program].loop;
+	}
+
+	g_run[i].key = key;
+
+	return 1;
+}
+
+static void start(uint8_t program, uint8_t const *pmask, uint8_t stagger, uint8_t *pdelta)
+{
+	uint8_t const length = g_program[program].length;
+	uint8_t key = 0;
+
+	for (uint8_t i = 0; i < NUMBER_OF_LEDS; i++)
+	{
+		if (!(pmask[i >> 3] & (1 << (i & 0x07))))
+			continue;
+
+		g_run[i].program = program + 1;
+		g_run[i].key = key;
+		g_run[i].remain = key_time(program, key);
+
+		pdelta[2 + 2 * pdelta[1]] = i | LED_DELTA_ENABLE;
+		pdelta[3 + 2 * pdelta[1]] = g_program[program].key[key].profile;
+		pdelta[1]++;
+
+		key = (key + stagger) % length;
+	}
+}
+
+
+void ledseq_command(uint8_t const *p8bytes)
+{
+	uint8_t const program = p8bytes[2];
+
+	switch (p8bytes[1])
+	{
+	case LEDSEQ_OP_KEY:
+		{
+			uint8_t const key = p8bytes[3];
+
+			if (program < LEDSEQ_PROGRAMS && key < LEDSEQ_KEYFRAMES)
+			{
+				g_program[program].key[key].profile = p8bytes[4];
+				g_program[program].key[key].time_ms = p8bytes[5] | ((uint16_t)p8bytes[6] << 8);
+			}
+		}
+		break;
+
+	case LEDSEQ_OP_LOOP:
+		if (program < LEDSEQ_PROGRAMS)
+		{
+			uint8_t const length = (p8bytes[3] > LEDSEQ_KEYFRAMES) ? LEDSEQ_KEYFRAMES : p8bytes[3];
+
+			g_program[program].length = length;
+			g_program[program].loop = p8bytes[4];
+
+			// do not leave running outputs behind the end of the program
+
+			for (uint8_t i = 0; i < NUMBER_OF_LEDS; i++)
+			{
+				if (g_run[i].program == program + 1 && g_run[i].key >= length) {
+					g_run[i].program = 0;
+				}
+			}
+		}
+		break;
+
+	case LEDSEQ_OP_START:
+		if (program < LEDSEQ_PROGRAMS && g_program[program].length > 0)
+		{
+			uint8_t delta[2 + 2 * NUMBER_OF_LEDS];
+			delta[0] = LED_CMD_DELTA;
+			delta[1] = 0;
+
+			start(program, &p8bytes[3], p8bytes[7], delta);
+
+			if (delta[1] > 0) {
+				led_update_delta(delta, 2 + 2 * delta[1]);
+			}
+		}
+		break;
+
+	case LEDSEQ_OP_STOP:
+		for (uint8_t i = 0; i < NUMBER_OF_LEDS; i++)
+		{
+			if (p8bytes[2 + (i >> 3)] & (1 << (i & 0x07))) {
+				g_run[i].program = 0;
+			}
+		}
+		break;
+	}
+}
+
+
+// advance all sequenced outputs by the time since the last call, the keyframes that are
+// reached are applied at once with a single LED_CMD_DELTA update
+
+void ledseq_task(void)
+{
+	uint16_t const now = clock_ms();
+	uint16_t const dt = now - g_last_ms;
+
+	if (dt == 0)
+		return;
+
+	g_last_ms = now;
+
+	uint8_t delta[2 + 2 * NUMBER_OF_LEDS];
+	delta[0] = LED_CMD_DELTA;
+	delta[1] = 0;
+
+	for (uint8_t i = 0; i < NUMBER_OF_LEDS; i++)
+	{
+		if (g_run[i].program == 0)
+			continue;
+
+		if (g_run[i].remain > dt)
+		{
+			g_run[i].remain -= dt;
+			continue;
+		}
+
+		// skip the keyframes that are already over if we are late
+
+		uint16_t late = dt - g_run[i].remain;
+
+		for (;;)
+		{
+			if (!next_key(i))
+			{
+				g_run[i].program = 0;
+				break;
+			}
+
+			uint16_t const t = key_time(g_run[i].program - 1, g_run[i].key);
+
+			if (late < t)
+			{
+				g_run[i].remain = t - late;
+				break;
+			}
+
+			late -= t;
+		}
+
+		if (g_run[i].program != 0)
+		{
+			delta[2 + 2 * delta[1]] = i | LED_DELTA_ENABLE;
+			delta[3 + 2 * delta[1]] = g_program[g_run[i].program - 1].key[g_run[i].key].profile;
+			delta[1]++;
+		}
+	}
+
+	if (delta[1] > 0) {
+		led_update_delta(delta, 2 + 2 * delta[1]);
+	}
+}
+
+
+#endif
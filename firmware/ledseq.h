@@ -0,0 +1,59 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LWCLONE_LEDSEQ_H__INCLUDED
+#define LWCLONE_LEDSEQ_H__INCLUDED
+
+#include <stdint.h>
+
+
+// Keyframe sequencer: the host uploads short programs of (profile, duration) keyframes once and then
+// attaches outputs to them. The device steps through the keyframes on its own, so an animation costs
+// no USB traffic while it runs. All commands are 8 byte LED_CMD_SEQ reports:
+//
+// [LED_CMD_SEQ, LEDSEQ_OP_KEY, program, index, profile, time_lo, time_hi]
+//     set keyframe 'index', 'profile' is a PBA brightness/mode byte, the time is in ms
+// [LED_CMD_SEQ, LEDSEQ_OP_LOOP, program, length, loop]
+//     number of keyframes and the keyframe the program continues with after the last one,
+//     with loop >= length the outputs keep the last keyframe and are released
+// [LED_CMD_SEQ, LEDSEQ_OP_START, program, mask0, mask1, mask2, mask3, stagger]
+//     (re)start the program on the outputs of the bank masks, every further output in the mask
+//     starts 'stagger' keyframes later, e.g. for a chase
+// [LED_CMD_SEQ, LEDSEQ_OP_STOP, mask0, mask1, mask2, mask3]
+//     release the outputs, they keep their current state
+//
+// SBA/PBA reports to a sequenced output are overwritten at its next keyframe.
+
+#define LEDSEQ_OP_KEY    1
+#define LEDSEQ_OP_LOOP   2
+#define LEDSEQ_OP_START  3
+#define LEDSEQ_OP_STOP   4
+
+#if !defined(LEDSEQ_PROGRAMS)
+	#define LEDSEQ_PROGRAMS   4
+#endif
+
+#if !defined(LEDSEQ_KEYFRAMES)
+	#define LEDSEQ_KEYFRAMES  16
+#endif
+
+
+void ledseq_command(uint8_t const *p8bytes);
+void ledseq_task(void);
+
+
+
+#endif
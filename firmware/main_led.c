@@ -1,109 +1,210 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <avr/io.h>
-#include <avr/interrupt.h>
-#include <avr/wdt.h>
-#include <avr/sleep.h>
-
-#include <hwconfig.h>
-#include "comm.h"
-#include "led.h"
-#include "panel.h"
-
-
-int main(void)
-{
-	clock_init();
-	comm_init();
-	led_init();
-	panel_init();
-
-	set_sleep_mode(SLEEP_MODE_IDLE);
-
-	sei();
-
-	DbgOut(DBGINFO, "main_led, enter main loop");
-
-	for (;;)
-	{
-		// process LED messages
-
-		#if defined(LED_TIMER_vect)
-
-		msg_t * const prxmsg = msg_recv();
-
-		if (prxmsg != NULL)
-		{
-			DbgOut(DBGINFO, "main_led, message received");
-
-			// is the message valid?
-
-			if (prxmsg->nlen != 8)
-			{
-				DbgOut(DBGERROR, "main_led, invalid framesize");
-			}
-			else
-			{
-				// process the data
-				led_update(&prxmsg->data[0]);
-			}
-
-			msg_release();
-
-			continue;
-		}
-
-		#endif
-
-		// process panel changes
-
-		#if defined(PANEL_TASK)
-
-		uint8_t * pdata = NULL;
-		uint8_t const ndata = panel_get_report(&pdata);
-
-		if (ndata > 0)
-		{
-			msg_t * const ptxmsg = msg_prepare();
-
-			if (ptxmsg != NULL)
-			{
-				memcpy(&ptxmsg->data[0], pdata, ndata);
-				ptxmsg->nlen = ndata;
-				msg_send();
-			}
-			else
-			{
-				DbgOut(DBGERROR, "main_led, tx buffer overflow");
-			}
-
-			continue;
-		}
-
-		#endif
-
-		// if we are here, there was no new message and no new panel report
-		// ==> enter idle mode
-
-		sleep_ms(0);
-	}
-
-	return 0;
-}
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <avr/sleep.h>
+
+#include <hwconfig.h>
+#include "comm.h"
+#include "clock.h"
+#include "led.h"
+#include "ledseq.h"
+#include "panel.h"
+
+
+#if defined(LED_TIMER_vect)
+static void frame_fragment(uint8_t const *pdata, uint8_t ndata);
+static void timed_update(uint8_t *pdata, uint8_t ndata);
+#endif
+
+
+int main(void)
+{
+	clock_init();
+	comm_init();
+	led_init();
+	panel_init();
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+
+	sei();
+
+	DbgOut(DBGINFO, "main_led, enter main loop");
+
+	for (;;)
+	{
+		// negotiate the rate of the data link
+
+		comm_task();
+
+		// advance the LED sequencer
+
+		ledseq_task();
+
+		// write a saved scene to the EEPROM
+
+		led_task();
+
+		// process LED messages
+
+		#if defined(LED_TIMER_vect)
+
+		msg_t * const prxmsg = msg_recv();
+
+		if (prxmsg != NULL)
+		{
+			DbgOut(DBGINFO, "main_led, message received");
+
+			// is the message valid?
+
+			if (msg_channel() != MSG_CHANNEL_LED)
+			{
+				DbgOut(DBGERROR, "main_led, message on channel %d ignored", msg_channel());
+			}
+			else if (prxmsg->nlen > 2 && prxmsg->data[0] == LED_CMD_TIMED)
+			{
+				timed_update(&prxmsg->data[0], prxmsg->nlen);
+			}
+			else if (prxmsg->nlen > 2 && prxmsg->data[0] == LED_CMD_FRAME)
+			{
+				frame_fragment(&prxmsg->data[0], prxmsg->nlen);
+			}
+			else if (prxmsg->nlen > 2 && prxmsg->data[0] == LED_CMD_DELTA)
+			{
+				led_update_delta(&prxmsg->data[0], prxmsg->nlen);
+			}
+			else if (prxmsg->nlen > 2 && prxmsg->data[0] == LED_CMD_FADE)
+			{
+				led_update_fade(&prxmsg->data[0], prxmsg->nlen);
+			}
+			else if (prxmsg->nlen > 2 && prxmsg->data[0] == LED_CMD_BRIGHT)
+			{
+				led_update_bright(&prxmsg->data[0], prxmsg->nlen);
+			}
+			else if (prxmsg->nlen > 2 && prxmsg->data[0] == LED_CMD_PBA)
+			{
+				led_update_pba(&prxmsg->data[0], prxmsg->nlen);
+			}
+			else if (prxmsg->nlen == 8 || prxmsg->nlen == 9)
+			{
+				// process the data, the optional ninth byte is the LedWiz unit
+				led_update((prxmsg->nlen == 9) ? prxmsg->data[8] : 0, &prxmsg->data[0]);
+			}
+			else
+			{
+				DbgOut(DBGERROR, "main_led, invalid framesize");
+			}
+
+			msg_release();
+
+			continue;
+		}
+
+		#endif
+
+		// process panel changes
+
+		#if defined(PANEL_TASK)
+
+		uint8_t * pdata = NULL;
+		uint8_t const ndata = panel_get_report(&pdata);
+
+		if (ndata > 0)
+		{
+			msg_t * const ptxmsg = msg_prepare(MSG_CHANNEL_PANEL);
+
+			if (ptxmsg != NULL)
+			{
+				memcpy(&ptxmsg->data[0], pdata, ndata);
+				ptxmsg->nlen = ndata;
+				msg_send();
+			}
+			else
+			{
+				DbgOut(DBGERROR, "main_led, tx buffer overflow");
+			}
+
+			continue;
+		}
+
+		#endif
+
+		// if we are here, there was no new message and no new panel report
+		// ==> enter idle mode
+
+		sleep_ms(0);
+	}
+
+	return 0;
+}
+
+
+// reassemble a LED_CMD_FRAME report from the fragments [LED_CMD_FRAME, offset, data...] sent by main_usb.c,
+// a frame with a missing fragment is dropped
+
+#if defined(LED_TIMER_vect)
+
+static void frame_fragment(uint8_t const *pdata, uint8_t ndata)
+{
+	static uint8_t frame[LED_FRAME_SIZE];
+	static uint8_t pos = 0; // offset of the next expected fragment, 0 if there is none
+
+	uint8_t const offset = pdata[1];
+	uint8_t const n = ndata - 2;
+
+	if (offset == 1) {
+		pos = 1; // first fragment
+	}
+
+	if (offset != pos || offset + n > LED_FRAME_SIZE)
+	{
+		DbgOut(DBGERROR, "main_led, lost frame fragment");
+		pos = 0;
+		return;
+	}
+
+	memcpy(&frame[offset], &pdata[2], n);
+	pos += n;
+
+	if (pos == LED_FRAME_SIZE)
+	{
+		frame[0] = LED_CMD_FRAME;
+		led_update_frame(frame);
+		pos = 0;
+	}
+}
+
+
+
+// the time of a timed update is sent by main_usb.c as a delay, convert it to our own clock
+
+static void timed_update(uint8_t *pdata, uint8_t ndata)
+{
+	uint16_t const delay = pdata[LED_TIMED_TIME] | ((uint16_t)pdata[LED_TIMED_TIME + 1] << 8);
+	uint16_t const time = clock_ms() + delay;
+
+	pdata[LED_TIMED_TIME] = time & 0xFF;
+	pdata[LED_TIMED_TIME + 1] = time >> 8;
+
+	led_update_timed(pdata, ndata);
+}
+
+#endif
@@ -1,378 +1,830 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
-
-#include <stdint.h>
-#include <avr/io.h>
-#include <avr/sleep.h>
-#include <avr/interrupt.h>
-#include <avr/wdt.h>
-#include <avr/power.h>
-#include <avr/eeprom.h>
-#include <util/atomic.h>
-#include <util/delay.h>
-
-#include <LUFA/Drivers/USB/USB.h>
-#include "descriptors.h"
-
-#include <hwconfig.h>
-#include "comm.h"
-#include "led.h"
-#include "panel.h"
-
-
-#define LWCCONFIG_CMD_SETID 65
-#define LWCCONFIG_CMD_DFU   66
-
-#define LWC_CONFIG_IDENTIFIER 0xA62817B2   // some magic number(s)
-#define RESETSTATE_BOOTLOADER 0x42B8217C
-
-#define OFFSET_OF(_struct_, _member_) (((uint8_t*)&(((_struct_*)NULL)->_member_)) - (uint8_t*)NULL)
-
-
-uint32_t g_resetstate __attribute__ ((section (".noinit")));
-
-typedef struct {
-	uint32_t id; 
-	uint8_t ledwiz_id;
-	uint8_t reserved[7];
-} lwc_config_t;
-
-static struct {
-	uint8_t reserved[16];
-	uint8_t configdata[sizeof(lwc_config_t)];
-} g_eeprom_table EEMEM;
-
-
-static void hardware_init(void);
-static void main_task(void);
-static uint8_t* buffer_lock(void);
-static void buffer_unlock(void);
-static void hardware_restart(bool enter_bootloader);
-static void configure_device(void);
-
-
-// Main program entry point. This routine configures the hardware required by the application, then
-// enters a loop to run the application tasks in sequence.
-
-int main(void)
-{
-	hardware_init();
-	USB_Init();
-
-	sei();
-
-	DbgOut(DBGINFO, "enter main loop");
-
-	do {
-		USB_USBTask();
-	} while (USB_DeviceState != DEVICE_STATE_Configured);
-
-	for (;;)
-	{
-		USB_USBTask();
-		main_task();
-		sleep_ms(0);
-	}
-}
-
-
-static void hardware_init(void)
-{
-	uint8_t const mcusr = MCUSR; // save status register
-
-	// Disable watchdog if enabled by bootloader/fuses
-	MCUSR &= ~(1 << WDRF);
-	wdt_disable();
-
-	#if defined(BOOTLOADER_START_ADDR)
-	// if that was a reset due to watchdog timeout that we issued, call the bootloader
-	if ((mcusr & (1 << WDRF)) && 
-	    (g_resetstate == RESETSTATE_BOOTLOADER))
-	{
-		g_resetstate = 0;
-		void (*bootloader)(void) = (void*)(BOOTLOADER_START_ADDR);
-		bootloader();
-	}
-	#endif
-
-	// Disable clock division
-	clock_prescale_set(clock_div_1);
-
-	set_sleep_mode(SLEEP_MODE_IDLE);
-
-	// initialize LED driver and UART and panel
-	clock_init();
-	comm_init();
-	led_init();
-	panel_init();
-
-	// config
-	configure_device();
-}
-
-
-// load current configuration from eeprom and set USB product ID
-
-static void configure_device(void)
-{
-	lwc_config_t cfg;
-	eeprom_read_block((void*)&cfg, g_eeprom_table.configdata, sizeof(cfg));
-
-	if (cfg.id != LWC_CONFIG_IDENTIFIER)
-	{
-		memset(&cfg, 0x00, sizeof(cfg));
-		cfg.id = LWC_CONFIG_IDENTIFIER;
-		cfg.ledwiz_id = USB_PRODUCT_ID & 0x0F;
-
-		eeprom_write_block((void*)&cfg, g_eeprom_table.configdata, sizeof(cfg));
-	}
-
-	// set USB product ID
-	uint16_t const product_id = (USB_PRODUCT_ID & ~0x000F) | (cfg.ledwiz_id & 0x0F);
-	SetProductID(product_id);
-}
-
-
-static void main_task(void)
-{
-#if defined(ENABLE_PANEL_DEVICE)
-
-	/* Select the Joystick Report Endpoint */
-	Endpoint_SelectEndpoint(PANEL_EPADDR);
-
-	/* Check to see if the host is ready for another packet */
-	if (!Endpoint_IsINReady())
-		return;
-
-	#if defined(DATA_RX_UART_vect)
-
-	msg_t * const pmsg = msg_recv();
-
-	if (pmsg != NULL)
-	{
-		DbgOut(DBGINFO, "main_usb, message received");
-
-		// is the message valid?
-
-		if (pmsg->nlen < 2 || pmsg->nlen > 8)
-		{
-			DbgOut(DBGERROR, "main_usb, invalid framesize");
-		}
-		else
-		{
-			/* Write Joystick Report Data */
-			Endpoint_Write_Stream_LE(&pmsg->data[0], pmsg->nlen, NULL);
-
-			/* Finalize the stream transfer to send the last packet */
-			Endpoint_ClearIN();
-		}
-
-		msg_release();
-	}
-
-	#elif defined(PANEL_TASK)
-
-	uint8_t * pdata;
-	uint8_t const ndata = panel_get_report(&pdata);
-
-	if (ndata > 0)
-	{
-		/* Write Joystick Report Data */
-		Endpoint_Write_Stream_LE(pdata, ndata, NULL);
-
-		/* Finalize the stream transfer to send the last packet */
-		Endpoint_ClearIN();
-	}
-
-	#else
-
-	#error "invalid configuration, panel is enabled but no uart-rx-ISR or panel-timer-ISR"
-
-	#endif
-
-#endif
-}
-
-
-// Event handler for the USB_Connect event. This indicates that the device is enumerating via the status LEDs and
-// starts the library USB task to begin the enumeration and USB management process.
- 
-void EVENT_USB_Device_Connect(void)
-{
-}
-
-// Event handler for the USB_Disconnect event. This indicates that the device is no longer connected to a host via
-// the status LEDs and stops the USB management and joystick reporting tasks.
- 
-void EVENT_USB_Device_Disconnect(void)
-{
-}
-
-// Event handler for the library USB Configuration Changed event.
-
-void EVENT_USB_Device_ConfigurationChanged(void)
-{
-	// Setup HID Report Endpoint
-
-	Endpoint_ConfigureEndpoint(MISC_EPADDR, EP_TYPE_INTERRUPT, MISC_EPSIZE, 1);
-	#if defined(ENABLE_LED_DEVICE)
-	Endpoint_ConfigureEndpoint(LED_EPADDR, EP_TYPE_INTERRUPT, LED_EPSIZE, 1);
-	#endif
-	#if defined(ENABLE_PANEL_DEVICE)
-	Endpoint_ConfigureEndpoint(PANEL_EPADDR, EP_TYPE_INTERRUPT, PANEL_EPSIZE, 1);
-	#endif
-}
-
-// Event handler for the USB_ControlRequest event. This is used to catch and process control requests sent to
-// the device from the USB host before passing along unhandled control requests to the library for processing
-// internally.
- 
-void EVENT_USB_Device_ControlRequest(void)
-{
-	// Handle HID Class specific requests
-	switch (USB_ControlRequest.bRequest)
-	{
-	case HID_REQ_GetReport:
-		if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE))
-		{
-			Endpoint_ClearSETUP();
-
-			uint8_t zero = 0;
-
-			// Write one 'zero' byte report data to the control endpoint
-			Endpoint_Write_Control_Stream_LE(&zero, 1);
-			Endpoint_ClearOUT();
-		}
-		break;
-
-	#if defined(ENABLE_LED_DEVICE)
-	case HID_REQ_SetReport:
-		if (USB_ControlRequest.bmRequestType == (REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE))
-		{
-			Endpoint_ClearSETUP();
-
-			DbgOut(DBGINFO, "HID_REQ_SetReport, bRequest: 0x%02X, wIndex: %d, wLength: %d, wValue: %d",
-				USB_ControlRequest.bRequest, USB_ControlRequest.wIndex, USB_ControlRequest.wLength, USB_ControlRequest.wValue);
-
-			uint8_t * const pdata = buffer_lock();
-
-			if (pdata != NULL)
-			{
-				// Read the report data from the control endpoint
-				Endpoint_Read_Control_Stream_LE(pdata, 8);
-
-				DbgOut(DBGINFO, "HID_REQ_SetReport: %02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x", 
-					pdata[0], pdata[1], pdata[2], pdata[3], pdata[4], pdata[5], pdata[6], pdata[7]);
-
-				// if this is a special command to set the ledwiz ID, execute it
-				if (pdata[0] == LWCCONFIG_CMD_SETID)
-				{
-					const uint8_t id = pdata[1];
-					const uint8_t check = ~id;
-
-					if (pdata[2] == 0xFF &&
-					    pdata[3] == 0xFF &&
-					    pdata[4] == 0xFF &&
-					    pdata[5] == 0xFF &&
-					    pdata[6] == 0xFF &&
-					    pdata[7] == check)
-					{
-						eeprom_update_byte(
-							&g_eeprom_table.configdata[0] + OFFSET_OF(lwc_config_t, ledwiz_id),
-							id & 0x0F);
-
-						hardware_restart(false);
-					}
-				}
-
-				buffer_unlock();
-			}
-			else
-			{
-				uint8_t temp[8];
-				Endpoint_Read_Control_Stream_LE(temp, 8); // drop data
-
-				DbgOut(DBGERROR, "HID_REQ_SetReport: buffer overflow");
-			}
-
-			Endpoint_ClearIN();
-		}
-		break;
-	#endif
-	}
-}
-
-
-static void hardware_restart(bool enter_bootloader)
-{
-	// detach from the bus
-	USB_Disable();
-	USB_Detach();
-
-	// Disable all interrupts
-	cli();
-
-	// Wait some time for the USB detachment to register on the host
-	_delay_ms(250);
-
-	// force a reset via watchdog timeout
-	wdt_enable(WDTO_15MS);
-
-	// set persistant variable, so we know that we issued the reset
-	g_resetstate = enter_bootloader ? RESETSTATE_BOOTLOADER : 0;
-
-	for (;;) {;}
-}
-
-
-#if defined(LED_TIMER_vect)
-
-static uint8_t g_databuffer[8];
-
-static uint8_t * buffer_lock(void)
-{
-	return &g_databuffer[0];
-}
-
-void buffer_unlock(void)
-{
-	led_update(&g_databuffer[0]);
-}
-
-#endif
-
-
-#if defined(DATA_TX_UART_vect)
-
-static uint8_t * buffer_lock(void)
-{
-	msg_t * const pmsg = msg_prepare();
-
-	if (pmsg == NULL) {
-		return NULL;
-	}
-
-	pmsg->nlen = 8;
-
-	return &pmsg->data[0];
-}
-
-static void buffer_unlock(void)
-{
-	msg_send();
-}
-
-#endif
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <avr/power.h>
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+
+#include <LUFA/Drivers/USB/USB.h>
+#include "descriptors.h"
+
+#include <hwconfig.h>
+#include "comm.h"
+#include "clock.h"
+#include "led.h"
+#include "ledseq.h"
+#include "panel.h"
+
+
+#define LWCCONFIG_CMD_SETID 65
+#define LWCCONFIG_CMD_DFU   66
+
+#define LWC_CONFIG_IDENTIFIER 0xA62817B2   // some magic number(s)
+#define RESETSTATE_BOOTLOADER 0x42B8217C
+
+#define LINK_WAIT_MS 100   // longest wait for room on the link in a SET_REPORT request, it is stalled after that
+
+#define OFFSET_OF(_struct_, _member_) (((uint8_t*)&(((_struct_*)NULL)->_member_)) - (uint8_t*)NULL)
+
+
+uint32_t g_resetstate __attribute__ ((section (".noinit")));
+
+typedef struct {
+	uint32_t id; 
+	uint8_t ledwiz_id;
+	uint8_t reserved[7];
+} lwc_config_t;
+
+static struct {
+	uint8_t reserved[16];
+	uint8_t configdata[sizeof(lwc_config_t)];
+} g_eeprom_table EEMEM;
+
+
+static void hardware_init(void);
+static void main_task(void);
+static uint8_t* buffer_lock(void);
+static void buffer_unlock(uint8_t unit);
+static bool frame_update(uint8_t const *pframe);
+static bool delta_update(uint8_t const *pdata);
+static bool fade_update(uint8_t const *pdata);
+static bool timed_update(uint8_t const *pdata);
+static bool bright_update(uint8_t const *pdata);
+static bool pba_update(uint8_t const *pdata);
+static void config_command(uint8_t const *pdata);
+static void hardware_restart(bool enter_bootloader);
+static void configure_device(void);
+
+
+// Main program entry point. This routine configures the hardware required by the application, then
+// enters a loop to run the application tasks in sequence.
+
+int main(void)
+{
+	hardware_init();
+	USB_Init();
+
+	sei();
+
+	DbgOut(DBGINFO, "enter main loop");
+
+	do {
+		USB_USBTask();
+	} while (USB_DeviceState != DEVICE_STATE_Configured);
+
+	for (;;)
+	{
+		USB_USBTask();
+		comm_task();
+		main_task();
+		ledseq_task();
+		led_task();
+		sleep_ms(0);
+	}
+}
+
+
+static void hardware_init(void)
+{
+	uint8_t const mcusr = MCUSR; // save status register
+
+	// Disable watchdog if enabled by bootloader/fuses
+	MCUSR &= ~(1 << WDRF);
+	wdt_disable();
+
+	#if defined(BOOTLOADER_START_ADDR)
+	// if that was a reset due to watchdog timeout that we issued, call the bootloader
+	if ((mcusr & (1 << WDRF)) && 
+	    (g_resetstate == RESETSTATE_BOOTLOADER))
+	{
+		g_resetstate = 0;
+		void (*bootloader)(void) = (void*)(BOOTLOADER_START_ADDR);
+		bootloader();
+	}
+	#endif
+
+	// Disable clock division
+	clock_prescale_set(clock_div_1);
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+
+	// initialize LED driver and UART and panel
+	clock_init();
+	comm_init();
+	led_init();
+	panel_init();
+
+	// config
+	configure_device();
+}
+
+
+// load current configuration from eeprom and set USB product ID
+
+static void configure_device(void)
+{
+	lwc_config_t cfg;
+	eeprom_read_block((void*)&cfg, g_eeprom_table.configdata, sizeof(cfg));
+
+	if (cfg.id != LWC_CONFIG_IDENTIFIER)
+	{
+		memset(&cfg, 0x00, sizeof(cfg));
+		cfg.id = LWC_CONFIG_IDENTIFIER;
+		cfg.ledwiz_id = USB_PRODUCT_ID & 0x0F;
+
+		eeprom_write_block((void*)&cfg, g_eeprom_table.configdata, sizeof(cfg));
+	}
+
+	// set USB product ID
+	uint16_t const product_id = (USB_PRODUCT_ID & ~0x000F) | (cfg.ledwiz_id & 0x0F);
+	SetProductID(product_id);
+}
+
+
+static void main_task(void)
+{
+#if defined(ENABLE_LED_DEVICE)
+
+	/* Select the LED Report OUT Endpoint */
+	Endpoint_SelectEndpoint(LED_OUT_EPADDR);
+
+	// drain all received reports, if there is no free buffer the packet stays in the
+	// endpoint and the host is NAKed until there is one
+
+	while (Endpoint_IsOUTReceived())
+	{
+		uint8_t * const pdata = buffer_lock();
+
+		if (pdata == NULL)
+			break;
+
+		// with several LedWiz units the report ID in front of the report is the unit + 1
+
+		uint8_t report[LED_REPORTID_SIZE + 8];
+		uint8_t const ndata = Endpoint_BytesInEndpoint();
+
+		memset(report, 0x00, sizeof(report));
+		Endpoint_Read_Stream_LE(report, (ndata > sizeof(report)) ? sizeof(report) : ndata, NULL);
+		Endpoint_ClearOUT();
+
+		uint8_t const unit = (LED_REPORTID_SIZE > 0) ? report[0] - 1 : 0;
+
+		if (unit >= LED_UNITS)
+			continue;
+
+		memcpy(pdata, &report[LED_REPORTID_SIZE], 8);
+
+		config_command(pdata);
+
+		buffer_unlock(unit);
+	}
+
+#endif
+
+#if defined(ENABLE_PANEL_DEVICE)
+
+	/* Select the Joystick Report Endpoint */
+	Endpoint_SelectEndpoint(PANEL_EPADDR);
+
+	/* Check to see if the host is ready for another packet */
+	if (!Endpoint_IsINReady())
+		return;
+
+	#if defined(DATA_RX_UART_vect)
+
+	msg_t * const pmsg = msg_recv();
+
+	if (pmsg != NULL)
+	{
+		DbgOut(DBGINFO, "main_usb, message received");
+
+		// is the message valid? (an old LED controller sends its panel reports on the LED channel)
+
+		if (msg_channel() == MSG_CHANNEL_BULK)
+		{
+			DbgOut(DBGERROR, "main_usb, bulk message ignored");
+		}
+		else if (pmsg->nlen < 2 || pmsg->nlen > 8)
+		{
+			DbgOut(DBGERROR, "main_usb, invalid framesize");
+		}
+		else
+		{
+			/* Write Joystick Report Data */
+			Endpoint_Write_Stream_LE(&pmsg->data[0], pmsg->nlen, NULL);
+
+			/* Finalize the stream transfer to send the last packet */
+			Endpoint_ClearIN();
+		}
+
+		msg_release();
+	}
+
+	#elif defined(PANEL_TASK)
+
+	uint8_t * pdata;
+	uint8_t const ndata = panel_get_report(&pdata);
+
+	if (ndata > 0)
+	{
+		/* Write Joystick Report Data */
+		Endpoint_Write_Stream_LE(pdata, ndata, NULL);
+
+		/* Finalize the stream transfer to send the last packet */
+		Endpoint_ClearIN();
+	}
+
+	#else
+
+	#error "invalid configuration, panel is enabled but no uart-rx-ISR or panel-timer-ISR"
+
+	#endif
+
+#endif
+}
+
+
+// Event handler for the USB_Connect event. This indicates that the device is enumerating via the status LEDs and
+// starts the library USB task to begin the enumeration and USB management process.
+ 
+void EVENT_USB_Device_Connect(void)
+{
+}
+
+// Event handler for the USB_Disconnect event. This indicates that the device is no longer connected to a host via
+// the status LEDs and stops the USB management and joystick reporting tasks.
+ 
+void EVENT_USB_Device_Disconnect(void)
+{
+}
+
+// Event handler for the library USB Configuration Changed event.
+
+void EVENT_USB_Device_ConfigurationChanged(void)
+{
+	// Setup HID Report Endpoint
+
+	Endpoint_ConfigureEndpoint(MISC_EPADDR, EP_TYPE_INTERRUPT, MISC_EPSIZE, 1);
+	#if defined(ENABLE_LED_DEVICE)
+	Endpoint_ConfigureEndpoint(LED_EPADDR, EP_TYPE_INTERRUPT, LED_EPSIZE, 1);
+	Endpoint_ConfigureEndpoint(LED_OUT_EPADDR, EP_TYPE_INTERRUPT, LED_OUT_EPSIZE, 1);
+	#endif
+	#if defined(ENABLE_PANEL_DEVICE)
+	Endpoint_ConfigureEndpoint(PANEL_EPADDR, EP_TYPE_INTERRUPT, PANEL_EPSIZE, 1);
+	#endif
+}
+
+// Event handler for the USB_ControlRequest event. This is used to catch and process control requests sent to
+// the device from the USB host before passing along unhandled control requests to the library for processing
+// internally.
+ 
+void EVENT_USB_Device_ControlRequest(void)
+{
+	// Handle HID Class specific requests
+	switch (USB_ControlRequest.bRequest)
+	{
+	case HID_REQ_GetReport:
+		if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE))
+		{
+			Endpoint_ClearSETUP();
+
+			// the misc interface reports the device clock, so the host can map its own clock onto it
+
+			if ((USB_ControlRequest.wIndex & 0xFF) == IFACENUMBER_MISC)
+			{
+				uint8_t data[MISC_REPORT_SIZE];
+				uint16_t const ndata = (USB_ControlRequest.wLength > sizeof(data)) ? sizeof(data) : USB_ControlRequest.wLength;
+
+				memset(data, 0x00, sizeof(data));
+
+				uint32_t const ticks = clock();
+				uint16_t const ms = clock_ms();
+
+				data[0] = LED_CMD_CLOCK;
+				data[LED_CLOCK_MS + 0] = ms & 0xFF;
+				data[LED_CLOCK_MS + 1] = ms >> 8;
+				data[LED_CLOCK_TICKS + 0] = ticks & 0xFF;
+				data[LED_CLOCK_TICKS + 1] = (ticks >> 8) & 0xFF;
+				data[LED_CLOCK_TICKS + 2] = (ticks >> 16) & 0xFF;
+				data[LED_CLOCK_TICKS + 3] = ticks >> 24;
+
+				Endpoint_Write_Control_Stream_LE(data, ndata);
+				Endpoint_ClearOUT();
+				break;
+			}
+
+			uint8_t zero = 0;
+
+			// Write one 'zero' byte report data to the control endpoint
+			Endpoint_Write_Control_Stream_LE(&zero, 1);
+			Endpoint_ClearOUT();
+		}
+		break;
+
+	#if defined(ENABLE_LED_DEVICE)
+	case HID_REQ_SetReport:
+		if (USB_ControlRequest.bmRequestType == (REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE))
+		{
+			Endpoint_ClearSETUP();
+
+			DbgOut(DBGINFO, "HID_REQ_SetReport, bRequest: 0x%02X, wIndex: %d, wLength: %d, wValue: %d",
+				USB_ControlRequest.bRequest, USB_ControlRequest.wIndex, USB_ControlRequest.wLength, USB_ControlRequest.wValue);
+
+			// the misc interface takes the extended (64 byte) reports, the LED interface the LedWiz (8 byte) reports
+
+			if ((USB_ControlRequest.wIndex & 0xFF) == IFACENUMBER_MISC)
+			{
+				uint8_t data[MISC_REPORT_SIZE];
+				uint8_t const ndata = (USB_ControlRequest.wLength > sizeof(data)) ? sizeof(data) : USB_ControlRequest.wLength;
+
+				memset(data, 0x00, sizeof(data));
+				Endpoint_Read_Control_Stream_LE(data, ndata);
+
+				bool sent = true;
+
+				if (data[0] == LED_CMD_FRAME)
+				{
+					sent = frame_update(data);
+				}
+				else if (data[0] == LED_CMD_DELTA)
+				{
+					sent = delta_update(data);
+				}
+				else if (data[0] == LED_CMD_FADE)
+				{
+					sent = fade_update(data);
+				}
+				else if (data[0] == LED_CMD_TIMED)
+				{
+					sent = timed_update(data);
+				}
+				else if (data[0] == LED_CMD_BRIGHT)
+				{
+					sent = bright_update(data);
+				}
+				else if (data[0] == LED_CMD_PBA)
+				{
+					sent = pba_update(data);
+				}
+
+				// if the link had no room for too long the report is stalled, so the host sees the error
+
+				if (sent)
+				{
+					Endpoint_ClearIN();
+				}
+				else
+				{
+					DbgOut(DBGERROR, "HID_REQ_SetReport: extended report dropped");
+					Endpoint_StallTransaction();
+				}
+				break;
+			}
+
+			// Read the report data from the control endpoint, with several LedWiz units
+			// the report ID in front of the report is the unit + 1
+
+			uint8_t report[LED_REPORTID_SIZE + 8];
+			Endpoint_Read_Control_Stream_LE(report, sizeof(report));
+
+			uint8_t const unit = (LED_REPORTID_SIZE > 0) ? report[0] - 1 : 0;
+			uint8_t * pdata = NULL;
+
+			// wait for a free buffer instead of dropping the report, the host is NAKed in the status
+			// stage meanwhile (the link only holds messages while the LED controller has no room),
+			// after LINK_WAIT_MS the report is dropped and the request stalled
+
+			if (unit < LED_UNITS)
+			{
+				uint16_t const t_start = clock_ms();
+
+				while ((pdata = buffer_lock()) == NULL)
+				{
+					if ((uint16_t)(clock_ms() - t_start) >= LINK_WAIT_MS) {
+						break;
+					}
+
+					comm_task();
+				}
+			}
+
+			if (pdata != NULL)
+			{
+				memcpy(pdata, &report[LED_REPORTID_SIZE], 8);
+
+				DbgOut(DBGINFO, "HID_REQ_SetReport: %02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x", 
+					pdata[0], pdata[1], pdata[2], pdata[3], pdata[4], pdata[5], pdata[6], pdata[7]);
+
+				config_command(pdata);
+
+				buffer_unlock(unit);
+			}
+			else
+			{
+				DbgOut(DBGERROR, "HID_REQ_SetReport: report dropped");
+
+				if (unit < LED_UNITS)
+				{
+					Endpoint_StallTransaction();
+					break;
+				}
+			}
+
+			Endpoint_ClearIN();
+		}
+		break;
+	#endif
+	}
+}
+
+
+// if this is a special command to set the ledwiz ID, execute it
+
+static void config_command(uint8_t const *pdata)
+{
+	if (pdata[0] == LWCCONFIG_CMD_SETID)
+	{
+		const uint8_t id = pdata[1];
+		const uint8_t check = ~id;
+
+		if (pdata[2] == 0xFF &&
+		    pdata[3] == 0xFF &&
+		    pdata[4] == 0xFF &&
+		    pdata[5] == 0xFF &&
+		    pdata[6] == 0xFF &&
+		    pdata[7] == check)
+		{
+			eeprom_update_byte(
+				&g_eeprom_table.configdata[0] + OFFSET_OF(lwc_config_t, ledwiz_id),
+				id & 0x0F);
+
+			hardware_restart(false);
+		}
+	}
+}
+
+
+static void hardware_restart(bool enter_bootloader)
+{
+	// detach from the bus
+	USB_Disable();
+	USB_Detach();
+
+	// Disable all interrupts
+	cli();
+
+	// Wait some time for the USB detachment to register on the host
+	_delay_ms(250);
+
+	// force a reset via watchdog timeout
+	wdt_enable(WDTO_15MS);
+
+	// set persistant variable, so we know that we issued the reset
+	g_resetstate = enter_bootloader ? RESETSTATE_BOOTLOADER : 0;
+
+	for (;;) {;}
+}
+
+
+#if defined(LED_TIMER_vect)
+
+static uint8_t g_databuffer[8];
+
+static uint8_t * buffer_lock(void)
+{
+	return &g_databuffer[0];
+}
+
+void buffer_unlock(uint8_t unit)
+{
+	led_update(unit, &g_databuffer[0]);
+}
+
+static bool frame_update(uint8_t const *pframe)
+{
+	led_update_frame(pframe);
+	return true;
+}
+
+static bool delta_update(uint8_t const *pdata)
+{
+	led_update_delta(pdata, MISC_REPORT_SIZE);
+	return true;
+}
+
+static bool fade_update(uint8_t const *pdata)
+{
+	led_update_fade(pdata, MISC_REPORT_SIZE);
+	return true;
+}
+
+static bool timed_update(uint8_t const *pdata)
+{
+	led_update_timed(pdata, MISC_REPORT_SIZE);
+	return true;
+}
+
+static bool bright_update(uint8_t const *pdata)
+{
+	led_update_bright(pdata, MISC_REPORT_SIZE);
+	return true;
+}
+
+static bool pba_update(uint8_t const *pdata)
+{
+	led_update_pba(pdata, MISC_REPORT_SIZE);
+	return true;
+}
+
+#endif
+
+
+#if defined(DATA_TX_UART_vect)
+
+static uint8_t * buffer_lock(void)
+{
+	msg_t * const pmsg = msg_prepare(MSG_CHANNEL_LED);
+
+	if (pmsg == NULL) {
+		return NULL;
+	}
+
+	pmsg->nlen = 8;
+
+	return &pmsg->data[0];
+}
+
+// the link drains the fifo as soon as the LED controller has room, a LED controller that does not
+// take messages any more (hung, or the link went down) must not keep the USB controller in a control
+// request though, so the wait ends after LINK_WAIT_MS and the caller drops the rest of the report
+
+static msg_t * msg_wait(void)
+{
+	uint16_t const t_start = clock_ms();
+
+	for (;;)
+	{
+		msg_t * const pmsg = msg_prepare(MSG_CHANNEL_LED);
+
+		if (pmsg != NULL) {
+			return pmsg;
+		}
+
+		if ((uint16_t)(clock_ms() - t_start) >= LINK_WAIT_MS) {
+			return NULL;
+		}
+
+		comm_task();
+	}
+}
+
+// the LED controller has its own clock, so the time of a timed update is sent as a delay relative
+// to the time of sending and converted back by main_led.c
+
+static void timed_to_delay(uint8_t *pdata)
+{
+	uint16_t const time = pdata[LED_TIMED_TIME] | ((uint16_t)pdata[LED_TIMED_TIME + 1] << 8);
+	uint16_t const delay = time - clock_ms();
+
+	pdata[LED_TIMED_TIME] = delay & 0xFF;
+	pdata[LED_TIMED_TIME + 1] = delay >> 8;
+}
+
+static void buffer_unlock(uint8_t unit)
+{
+	msg_t * const pmsg = msg_prepare(MSG_CHANNEL_LED); // the message from buffer_lock(), it is not sent yet
+
+	// the extended commands are only taken from unit 0 (see led.h), main_led.c does not get the
+	// unit of those, so they are dropped here
+
+	if (unit > 0 && pmsg->data[0] >= LED_CMD_FIRST && pmsg->data[0] <= LED_CMD_LAST)
+		return;
+
+	if (pmsg->data[0] == LED_CMD_TIMED) {
+		timed_to_delay(&pmsg->data[0]);
+	}
+
+	// the LedWiz unit is sent as a ninth byte, the reports of unit 0 stay plain 8 byte messages
+
+	if (unit > 0)
+	{
+		pmsg->data[8] = unit;
+		pmsg->nlen = 9;
+	}
+
+	msg_send();
+}
+
+// a frame does not fit into one message, so it is sent as fragments [LED_CMD_FRAME, offset, data...]
+// that are reassembled by main_led.c, the frame is applied when the last fragment has arrived
+
+#define FRAGMENT_SIZE (MSG_MAXLEN - 2)
+
+static bool frame_update(uint8_t const *pframe)
+{
+	for (uint8_t offset = 1; offset < LED_FRAME_SIZE; offset += FRAGMENT_SIZE)
+	{
+		msg_t * const pmsg = msg_wait();
+
+		if (pmsg == NULL) {
+			return false;
+		}
+
+		uint8_t const n = (LED_FRAME_SIZE - offset > FRAGMENT_SIZE) ? FRAGMENT_SIZE : (LED_FRAME_SIZE - offset);
+
+		pmsg->nlen = n + 2;
+		pmsg->data[0] = LED_CMD_FRAME;
+		pmsg->data[1] = offset;
+		memcpy(&pmsg->data[2], pframe + offset, n);
+
+		msg_send();
+	}
+
+	return true;
+}
+
+// a long delta list is split into several delta commands that fit into one message each
+
+#define DELTA_ENTRIES ((MSG_MAXLEN - 2) / 2)
+
+static bool delta_update(uint8_t const *pdata)
+{
+	uint8_t n = pdata[1];
+
+	if (n > (MISC_REPORT_SIZE - 2) / 2)
+		n = (MISC_REPORT_SIZE - 2) / 2;
+
+	pdata += 2;
+
+	while (n > 0)
+	{
+		msg_t * const pmsg = msg_wait();
+
+		if (pmsg == NULL) {
+			return false;
+		}
+
+		uint8_t const k = (n > DELTA_ENTRIES) ? DELTA_ENTRIES : n;
+
+		pmsg->nlen = 2 + 2 * k;
+		pmsg->data[0] = LED_CMD_DELTA;
+		pmsg->data[1] = k;
+		memcpy(&pmsg->data[2], pdata, 2 * k);
+
+		msg_send();
+
+		pdata += 2 * k;
+		n -= k;
+	}
+	return true;
+}
+
+// the targets of a fade are split the same way, every message gets a copy of the header
+
+#define FADE_TARGETS (MSG_MAXLEN - LED_FADE_TARGET)
+
+static bool fade_update(uint8_t const *pdata)
+{
+	uint8_t n = pdata[LED_FADE_COUNT];
+	uint8_t first = pdata[LED_FADE_FIRST];
+
+	if (n > MISC_REPORT_SIZE - LED_FADE_TARGET)
+		n = MISC_REPORT_SIZE - LED_FADE_TARGET;
+
+	uint8_t const *ptarget = pdata + LED_FADE_TARGET;
+
+	while (n > 0)
+	{
+		msg_t * const pmsg = msg_wait();
+
+		if (pmsg == NULL) {
+			return false;
+		}
+
+		uint8_t const k = (n > FADE_TARGETS) ? FADE_TARGETS : n;
+
+		pmsg->nlen = LED_FADE_TARGET + k;
+		memcpy(&pmsg->data[0], pdata, LED_FADE_FIRST);
+		pmsg->data[LED_FADE_FIRST] = first;
+		pmsg->data[LED_FADE_COUNT] = k;
+		memcpy(&pmsg->data[LED_FADE_TARGET], ptarget, k);
+
+		msg_send();
+
+		ptarget += k;
+		first += k;
+		n -= k;
+	}
+	return true;
+}
+
+#define TIMED_ENTRIES ((MSG_MAXLEN - LED_TIMED_ENTRY) / 2)
+
+static bool timed_update(uint8_t const *pdata)
+{
+	uint8_t n = pdata[LED_TIMED_COUNT];
+
+	if (n > (MISC_REPORT_SIZE - LED_TIMED_ENTRY) / 2)
+		n = (MISC_REPORT_SIZE - LED_TIMED_ENTRY) / 2;
+
+	uint8_t const *pentry = pdata + LED_TIMED_ENTRY;
+
+	while (n > 0)
+	{
+		msg_t * const pmsg = msg_wait();
+
+		if (pmsg == NULL) {
+			return false;
+		}
+
+		uint8_t const k = (n > TIMED_ENTRIES) ? TIMED_ENTRIES : n;
+
+		pmsg->nlen = LED_TIMED_ENTRY + 2 * k;
+		memcpy(&pmsg->data[0], pdata, LED_TIMED_COUNT);
+		pmsg->data[LED_TIMED_COUNT] = k;
+		memcpy(&pmsg->data[LED_TIMED_ENTRY], pentry, 2 * k);
+
+		timed_to_delay(&pmsg->data[0]);
+
+		msg_send();
+
+		pentry += 2 * k;
+		n -= k;
+	}
+	return true;
+}
+
+// LED_CMD_BRIGHT and LED_CMD_PBA have the same layout, [cmd, first, count, value * count], the
+// 'flags' of the count byte are passed on with the last message only
+
+#if (LED_BRIGHT_FIRST != LED_PBA_FIRST) || (LED_BRIGHT_COUNT != LED_PBA_COUNT) || (LED_BRIGHT_VALUE != LED_PBA_PROFILE)
+	#error "LED_CMD_BRIGHT and LED_CMD_PBA layouts differ"
+#endif
+
+#define RANGE_VALUES (MSG_MAXLEN - LED_BRIGHT_VALUE)
+
+static bool range_update(uint8_t const *pdata, uint8_t flags)
+{
+	uint8_t n = pdata[LED_BRIGHT_COUNT] & ~flags;
+	uint8_t first = pdata[LED_BRIGHT_FIRST];
+
+	if (n > MISC_REPORT_SIZE - LED_BRIGHT_VALUE)
+		n = MISC_REPORT_SIZE - LED_BRIGHT_VALUE;
+
+	uint8_t const *pvalue = pdata + LED_BRIGHT_VALUE;
+
+	while (n > 0)
+	{
+		msg_t * const pmsg = msg_wait();
+
+		if (pmsg == NULL) {
+			return false;
+		}
+
+		uint8_t const k = (n > RANGE_VALUES) ? RANGE_VALUES : n;
+
+		pmsg->nlen = LED_BRIGHT_VALUE + k;
+		pmsg->data[0] = pdata[0];
+		pmsg->data[LED_BRIGHT_FIRST] = first;
+		pmsg->data[LED_BRIGHT_COUNT] = k | ((k == n) ? (pdata[LED_BRIGHT_COUNT] & flags) : 0);
+		memcpy(&pmsg->data[LED_BRIGHT_VALUE], pvalue, k);
+
+		msg_send();
+
+		pvalue += k;
+		first += k;
+		n -= k;
+	}
+	return true;
+}
+
+static bool bright_update(uint8_t const *pdata)
+{
+	return range_update(pdata, 0);
+}
+
+static bool pba_update(uint8_t const *pdata)
+{
+	return range_update(pdata, LED_PBA_COMMIT);
+}
+
+#endif
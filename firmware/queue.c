@@ -1,90 +1,226 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
-
-#include <stdint.h>
-#include "queue.h"
-
-
-static uint8_t fifo_getlevel(fifo_t const *f) { return f->wpos - f->rpos; }
-static uint8_t fifo_getfree(fifo_t const *f) { return f->mask - fifo_getlevel(f) + 1; }
-
-
-int8_t queue_push(fifo_t *f, uint8_t x)
-{
-	uint8_t const nfree = fifo_getfree(f);
-
-	if (nfree == 0)
-		return -1;
-
-	uint8_t const index = f->wpos & f->mask;
-	f->buf[index] = x;
-	f->wpos += 1;
-
-	return 0;
-}
-
-
-int8_t queue_pop(fifo_t *f, uint8_t *px)
-{
-	uint8_t const ndata = fifo_getlevel(f);
-
-	if (ndata == 0 || px == NULL)
-		return -1;
-
-	uint8_t const index = f->rpos & f->mask;
-	*px = f->buf[index];
-	f->rpos += 1;
-
-	return 0;
-}
-
-
-uint8_t* chunk_peek(fifo_t *f)
-{
-	uint8_t const ndata = fifo_getlevel(f);
-
-	if (ndata == 0)
-		return NULL;
-
-	uint8_t index = f->rpos & f->mask;
-
-	return &f->buf[index];
-}
-
-
-void chunk_release(fifo_t *f)
-{
-	f->rpos += f->chunksize;
-}
-
-
-uint8_t* chunk_prepare(fifo_t *f)
-{
-	uint8_t const nfree = fifo_getfree(f);
-
-	if (nfree == 0)
-		return NULL;
-
-	uint8_t index = f->wpos & f->mask;
-
-	return &f->buf[index];
-}
-
-
-void chunk_push(fifo_t* f)
-{
-	f->wpos += f->chunksize;
-}
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdint.h>
+#include <util/atomic.h>
+#include "queue.h"
+
+
+static uint8_t fifo_getlevel(fifo_t const *f) { return f->wpos - f->rpos; }
+static uint8_t fifo_getfree(fifo_t const *f) { return f->mask - fifo_getlevel(f) + 1; }
+
+
+int8_t queue_push(fifo_t *f, uint8_t x)
+{
+	uint8_t const nfree = fifo_getfree(f);
+
+	if (nfree == 0)
+		return -1;
+
+	uint8_t const index = f->wpos & f->mask;
+	f->buf[index] = x;
+	f->wpos += 1;
+
+	return 0;
+}
+
+
+int8_t queue_pop(fifo_t *f, uint8_t *px)
+{
+	uint8_t const ndata = fifo_getlevel(f);
+
+	if (ndata == 0 || px == NULL)
+		return -1;
+
+	uint8_t const index = f->rpos & f->mask;
+	*px = f->buf[index];
+	f->rpos += 1;
+
+	return 0;
+}
+
+
+uint8_t* chunk_peek(fifo_t *f)
+{
+	uint8_t const ndata = fifo_getlevel(f);
+
+	if (ndata == 0)
+		return NULL;
+
+	uint8_t index = f->rpos & f->mask;
+
+	return &f->buf[index];
+}
+
+
+void chunk_release(fifo_t *f)
+{
+	f->rpos += f->chunksize;
+}
+
+
+uint8_t* chunk_prepare(fifo_t *f)
+{
+	uint8_t const nfree = fifo_getfree(f);
+
+	if (nfree == 0)
+		return NULL;
+
+	uint8_t index = f->wpos & f->mask;
+
+	return &f->buf[index];
+}
+
+
+void chunk_push(fifo_t* f)
+{
+	f->wpos += f->chunksize;
+}
+
+
+// record fifo
+
+static uint16_t rfifo_load(uint16_t volatile *ppos)
+{
+	uint16_t pos;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		pos = *ppos;
+	}
+
+	return pos;
+}
+
+static void rfifo_store(uint16_t volatile *ppos, uint16_t pos)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		*ppos = pos;
+	}
+}
+
+// bytes from position 'pos' to the next record, 0 if there is a record at 'pos'
+
+static uint16_t rfifo_skip(rfifo_t const *f, uint16_t pos)
+{
+	uint16_t const index = pos & f->mask;
+
+	return (f->buf[index] == RFIFO_WRAP) ? (f->mask + 1 - index) : 0;
+}
+
+
+uint8_t* record_prepare(rfifo_t *f, uint8_t size)
+{
+	uint16_t const wpos = f->wpos;
+	uint16_t const nfree = f->mask + 1 - (wpos - rfifo_load(&f->rpos));
+	uint16_t const tail = f->mask + 1 - (wpos & f->mask);
+	uint16_t const skip = (tail < size) ? tail : 0;
+
+	if (nfree < skip + size)
+		return NULL;
+
+	f->wnext = wpos + skip;
+
+	return &f->buf[f->wnext & f->mask];
+}
+
+
+void record_push(rfifo_t *f)
+{
+	uint16_t const wpos = f->wpos;
+
+	if (f->wnext != wpos) {
+		f->buf[wpos & f->mask] = RFIFO_WRAP;
+	}
+
+	rfifo_store(&f->wpos, f->wnext + f->buf[f->wnext & f->mask] + 1);
+}
+
+
+uint8_t* record_peek(rfifo_t *f)
+{
+	uint16_t const rpos = f->rpos;
+
+	if (rfifo_load(&f->wpos) == rpos)
+		return NULL;
+
+	return &f->buf[(rpos + rfifo_skip(f, rpos)) & f->mask];
+}
+
+
+// the record after 'p', NULL if it is the last one, so a consumer can look at several records
+
+uint8_t* record_next(rfifo_t *f, uint8_t const *p)
+{
+	uint16_t const rpos = f->rpos;
+	uint16_t const nused = rfifo_load(&f->wpos) - rpos;
+	uint16_t offset = ((uint16_t)(p - f->buf) - rpos) & f->mask;
+
+	offset += p[0] + 1;
+
+	if (offset < nused) {
+		offset += rfifo_skip(f, rpos + offset);
+	}
+
+	if (offset >= nused)
+		return NULL;
+
+	return &f->buf[(rpos + offset) & f->mask];
+}
+
+
+// release the first n records at once
+
+void record_release(rfifo_t *f, uint8_t n)
+{
+	uint16_t const wpos = rfifo_load(&f->wpos);
+	uint16_t rpos = f->rpos;
+
+	while (n > 0 && rpos != wpos)
+	{
+		rpos += rfifo_skip(f, rpos);
+		rpos += f->buf[rpos & f->mask] + 1;
+		n--;
+	}
+
+	rfifo_store(&f->rpos, rpos);
+}
+
+
+// number of records of up to 'size' bytes that can be pushed for sure, one of them may have to skip
+// the end of the buffer
+
+uint16_t record_getfree(rfifo_t *f, uint8_t size)
+{
+	uint16_t const nfree = f->mask + 1 - (f->wpos - rfifo_load(&f->rpos));
+
+	return (nfree >= size) ? (nfree - size + 1) / size : 0;
+}
+
+
+// the largest record that record_prepare() can give right now
+
+uint16_t rfifo_getcontig(rfifo_t *f)
+{
+	uint16_t const nfree = f->mask + 1 - (f->wpos - rfifo_load(&f->rpos));
+	uint16_t const tail = f->mask + 1 - (f->wpos & f->mask);
+
+	if (nfree <= tail)
+		return nfree;
+
+	return (tail > nfree - tail) ? tail : nfree - tail;
+}
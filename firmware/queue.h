@@ -1,59 +1,93 @@
-/*
- * LWCloneU2
- * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
- *
- * This program is free software; you can redistribute it and/or modify it under the terms of the
- * GNU General Public License as published by the Free Software Foundation;
- * either version 2 of the License, or (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
- * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
- * See the GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License along with this program;
- * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- */
-
-#ifndef QUEUE_H_INCLUDED
-#define QUEUE_H_INCLUDED
-
-#include <stdlib.h>
-#include <stdio.h>
-
-
-typedef struct {
-	uint8_t volatile rpos;
-	uint8_t volatile wpos;
-	uint8_t chunksize;
-	uint8_t mask;
-	uint8_t volatile buf[1];
-} fifo_t;
-
-
-// helper to allocate and initialize a fifo buffer 
-#define CREATE_FIFO(_name_, _num_chunks_log2_, _chunksize_log2_) \
-	union { \
-		uint8_t volatile _name_##_buffer__[sizeof(fifo_t) - 1 + (1 << (_num_chunks_log2_ + _chunksize_log2_))]; \
-		fifo_t fifo; \
-	} _name_##_fifo__ = { \
-		.fifo.chunksize = (1 << (_chunksize_log2_)), \
-		.fifo.mask = ((1 << (_num_chunks_log2_ + _chunksize_log2_)) - 1) \
-	}; \
-	fifo_t * const _name_ = &_name_##_fifo__.fifo;
-
-
-int8_t queue_push(fifo_t *f, uint8_t x);
-int8_t queue_pop(fifo_t *f, uint8_t *px);
-
-uint8_t* chunk_prepare(fifo_t *f);
-void chunk_push(fifo_t *f);
-uint8_t* chunk_peek(fifo_t *f);
-void chunk_release(fifo_t *f);
-
-
-
-#endif
-
-
-
-
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUEUE_H_INCLUDED
+#define QUEUE_H_INCLUDED
+
+#include <stdlib.h>
+#include <stdio.h>
+
+
+typedef struct {
+	uint8_t volatile rpos;
+	uint8_t volatile wpos;
+	uint8_t chunksize;
+	uint8_t mask;
+	uint8_t volatile buf[1];
+} fifo_t;
+
+
+// helper to allocate and initialize a fifo buffer 
+#define CREATE_FIFO(_name_, _num_chunks_log2_, _chunksize_log2_) \
+	union { \
+		uint8_t volatile _name_##_buffer__[sizeof(fifo_t) - 1 + (1 << (_num_chunks_log2_ + _chunksize_log2_))]; \
+		fifo_t fifo; \
+	} _name_##_fifo__ = { \
+		.fifo.chunksize = (1 << (_chunksize_log2_)), \
+		.fifo.mask = ((1 << (_num_chunks_log2_ + _chunksize_log2_)) - 1) \
+	}; \
+	fifo_t * const _name_ = &_name_##_fifo__.fifo;
+
+
+int8_t queue_push(fifo_t *f, uint8_t x);
+int8_t queue_pop(fifo_t *f, uint8_t *px);
+
+uint8_t* chunk_prepare(fifo_t *f);
+void chunk_push(fifo_t *f);
+uint8_t* chunk_peek(fifo_t *f);
+void chunk_release(fifo_t *f);
+
+
+// Record fifo: variable length records [n, n bytes] that are contiguous in the buffer, so a record
+// can be used in place (e.g. as a msg_t) and small records do not take a whole chunk. A record that
+// does not fit in before the end of the buffer starts at the beginning, the rest is marked with
+// RFIFO_WRAP. The positions are 16 bit, so the buffer can be larger than 256 bytes, and the
+// position of the other side is accessed atomically since one side is usually an interrupt.
+
+#define RFIFO_WRAP  0xFF
+
+typedef struct {
+	uint16_t volatile rpos;
+	uint16_t volatile wpos;
+	uint16_t wnext;  // writer: position of the record from record_prepare()
+	uint16_t mask;
+	uint8_t buf[1];
+} rfifo_t;
+
+#define CREATE_RFIFO(_name_, _size_log2_) \
+	union { \
+		uint8_t _name_##_buffer__[sizeof(rfifo_t) - 1 + (1 << (_size_log2_))]; \
+		rfifo_t fifo; \
+	} _name_##_rfifo__ = { \
+		.fifo.mask = ((1 << (_size_log2_)) - 1) \
+	}; \
+	rfifo_t * const _name_ = &_name_##_rfifo__.fifo;
+
+uint8_t* record_prepare(rfifo_t *f, uint8_t size);  // size includes the length byte
+void record_push(rfifo_t *f);
+uint8_t* record_peek(rfifo_t *f);
+uint8_t* record_next(rfifo_t *f, uint8_t const *p);
+void record_release(rfifo_t *f, uint8_t n);
+uint16_t record_getfree(rfifo_t *f, uint8_t size);
+uint16_t rfifo_getcontig(rfifo_t *f);
+
+
+
+#endif
+
+
+
+
@@ -0,0 +1,35 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// host stand-in: the EEPROM is ordinary memory and always ready
+
+#ifndef SIM_AVR_EEPROM_H__INCLUDED
+#define SIM_AVR_EEPROM_H__INCLUDED
+
+#include <stdint.h>
+#include <string.h>
+
+#define EEMEM
+
+static inline uint8_t eeprom_is_ready(void) { return 1; }
+static inline uint8_t eeprom_read_byte(uint8_t const *p) { return *p; }
+static inline uint16_t eeprom_read_word(uint16_t const *p) { return *p; }
+static inline void eeprom_read_block(void *dst, void const *src, size_t n) { memcpy(dst, src, n); }
+static inline void eeprom_update_byte(uint8_t *p, uint8_t value) { *p = value; }
+static inline void eeprom_update_word(uint16_t *p, uint16_t value) { *p = value; }
+static inline void eeprom_update_block(void const *src, void *dst, size_t n) { memcpy(dst, src, n); }
+
+#endif
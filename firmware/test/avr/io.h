@@ -0,0 +1,75 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Host stand-ins for the AVR registers that the tested modules touch. The registers are plain
+// memory in sim_reg[] (sim_io.c), SPSR is read through a function of the test, so a test can
+// see every byte that is written to SPDR.
+
+#ifndef SIM_AVR_IO_H__INCLUDED
+#define SIM_AVR_IO_H__INCLUDED
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+enum {
+	SIM_PORTA, SIM_PORTB, SIM_PORTC, SIM_PORTD, SIM_PORTE, SIM_PORTF,
+	SIM_PORTG, SIM_PORTH, SIM_PORTJ, SIM_PORTK, SIM_PORTL,
+	SIM_DDRA, SIM_DDRB, SIM_DDRC, SIM_DDRD, SIM_DDRE, SIM_DDRF,
+	SIM_DDRG, SIM_DDRH, SIM_DDRJ, SIM_DDRK, SIM_DDRL,
+	SIM_OCR0A, SIM_SPDR, SIM_SPCR,
+	SIM_NUMBER_OF_REGS
+};
+
+extern volatile uint8_t sim_reg[SIM_NUMBER_OF_REGS];
+
+#define PORTA  sim_reg[SIM_PORTA]
+#define PORTB  sim_reg[SIM_PORTB]
+#define PORTC  sim_reg[SIM_PORTC]
+#define PORTD  sim_reg[SIM_PORTD]
+#define PORTE  sim_reg[SIM_PORTE]
+#define PORTF  sim_reg[SIM_PORTF]
+#define PORTG  sim_reg[SIM_PORTG]
+#define PORTH  sim_reg[SIM_PORTH]
+#define PORTJ  sim_reg[SIM_PORTJ]
+#define PORTK  sim_reg[SIM_PORTK]
+#define PORTL  sim_reg[SIM_PORTL]
+#define DDRA   sim_reg[SIM_DDRA]
+#define DDRB   sim_reg[SIM_DDRB]
+#define DDRC   sim_reg[SIM_DDRC]
+#define DDRD   sim_reg[SIM_DDRD]
+#define DDRE   sim_reg[SIM_DDRE]
+#define DDRF   sim_reg[SIM_DDRF]
+#define DDRG   sim_reg[SIM_DDRG]
+#define DDRH   sim_reg[SIM_DDRH]
+#define DDRJ   sim_reg[SIM_DDRJ]
+#define DDRK   sim_reg[SIM_DDRK]
+#define DDRL   sim_reg[SIM_DDRL]
+#define OCR0A  sim_reg[SIM_OCR0A]
+#define SPDR   sim_reg[SIM_SPDR]
+#define SPCR   sim_reg[SIM_SPCR]
+#define SPSR   sim_spsr()
+
+uint8_t sim_spsr(void);
+
+#define PB0   0
+#define PB1   1
+#define PB2   2
+#define SPIF  7
+#define SPE   6
+#define MSTR  4
+
+#endif
@@ -0,0 +1,222 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Benchmark of the record fifo (rfifo_t) that holds the link messages against the chunk fifo
+// (fifo_t) with 16 byte chunks that held them before, both with 64 bytes of buffer. It prints how
+// many messages of a size fit in and the host time per message, run it with 'make bench'. The
+// times are those of the host CPU, only their ratio is a hint for the AVR.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "queue.h"
+
+#define MSG_MAXLEN  15          // as in comm.h
+#define ROUNDS      20000000L
+
+CREATE_FIFO(g_chunks, 2, 4)
+CREATE_RFIFO(g_records, 6)
+
+// message lengths of a typical mix: SBA/PBA reports, LED_CMD_PBA ranges, panel reports
+
+static uint8_t const g_mix[8] = { 8, 9, 15, 5, 8, 8, 4, 9 };
+
+static volatile uint32_t g_sink = 0;
+
+static double seconds(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// messages of nlen bytes that fit into the empty fifo, the record fifo is tried at every start position
+
+static void capacity(uint8_t nlen)
+{
+	int nchunks = 0;
+
+	while (chunk_prepare(g_chunks) != NULL)
+	{
+		g_chunks->buf[g_chunks->wpos & g_chunks->mask] = nlen;
+		chunk_push(g_chunks);
+		nchunks++;
+	}
+
+	while (chunk_peek(g_chunks) != NULL) {
+		chunk_release(g_chunks);
+	}
+
+	int nmin = 255;
+	long nsum = 0;
+
+	for (uint16_t start = 0; start <= g_records->mask; start++)
+	{
+		int n = 0;
+		uint8_t *p;
+
+		g_records->rpos = g_records->wpos = start;
+
+		while ((p = record_prepare(g_records, MSG_MAXLEN + 1)) != NULL)
+		{
+			p[0] = nlen;
+			record_push(g_records);
+			n++;
+		}
+
+		nmin = (n < nmin) ? n : nmin;
+		nsum += n;
+	}
+
+	g_records->rpos = g_records->wpos = 0;
+
+	printf("bench_fifo: %2u byte messages fit: chunk fifo %d, record fifo %.1f on average (at least %d)\n",
+		nlen, nchunks, (double)nsum / (g_records->mask + 1), nmin);
+}
+
+// the fifo is kept one message full, every round pushes one message and pops one
+
+static double single_chunks(void)
+{
+	double const t0 = seconds();
+
+	for (long i = 0; i < ROUNDS; i++)
+	{
+		uint8_t * const p = chunk_prepare(g_chunks);
+		p[0] = g_mix[i & 7];
+		memcpy(p + 1, &i, 4);
+		chunk_push(g_chunks);
+
+		if (i > 0)
+		{
+			uint8_t const * const q = chunk_peek(g_chunks);
+			g_sink += q[0] + q[1];
+			chunk_release(g_chunks);
+		}
+	}
+
+	while (chunk_peek(g_chunks) != NULL) {
+		chunk_release(g_chunks);
+	}
+
+	return (seconds() - t0) / ROUNDS;
+}
+
+static double single_records(void)
+{
+	double const t0 = seconds();
+
+	for (long i = 0; i < ROUNDS; i++)
+	{
+		uint8_t * const p = record_prepare(g_records, MSG_MAXLEN + 1);
+		p[0] = g_mix[i & 7];
+		memcpy(p + 1, &i, 4);
+		record_push(g_records);
+
+		if (i > 0)
+		{
+			uint8_t const * const q = record_peek(g_records);
+			g_sink += q[0] + q[1];
+			record_release(g_records, 1);
+		}
+	}
+
+	record_release(g_records, 1);
+
+	return (seconds() - t0) / ROUNDS;
+}
+
+// four messages are pushed and then taken out together, like a batch frame of the link
+
+static double batch_chunks(void)
+{
+	double const t0 = seconds();
+
+	for (long i = 0; i < ROUNDS / 4; i++)
+	{
+		for (uint8_t k = 0; k < 4; k++)
+		{
+			uint8_t * const p = chunk_prepare(g_chunks);
+			p[0] = g_mix[(i + k) & 7];
+			chunk_push(g_chunks);
+		}
+
+		uint8_t const *q;
+
+		while ((q = chunk_peek(g_chunks)) != NULL)
+		{
+			g_sink += q[0];
+			chunk_release(g_chunks);
+		}
+	}
+
+	return (seconds() - t0) / ROUNDS;
+}
+
+static double batch_records(void)
+{
+	double const t0 = seconds();
+
+	for (long i = 0; i < ROUNDS / 4; i++)
+	{
+		for (uint8_t k = 0; k < 4; k++)
+		{
+			uint8_t * const p = record_prepare(g_records, MSG_MAXLEN + 1);
+			p[0] = g_mix[(i + k) & 7];
+			record_push(g_records);
+		}
+
+		for (uint8_t const *q = record_peek(g_records); q != NULL; q = record_next(g_records, q)) {
+			g_sink += q[0];
+		}
+
+		record_release(g_records, 4);
+	}
+
+	return (seconds() - t0) / ROUNDS;
+}
+
+int main(void)
+{
+	static uint8_t const sizes[] = { 4, 5, 9, 15 };
+
+	for (uint8_t k = 0; k < sizeof(sizes); k++) {
+		capacity(sizes[k]);
+	}
+
+	// the first pass warms up the caches and the CPU clock
+
+	for (uint8_t pass = 0; pass < 2; pass++)
+	{
+		double const t_single_chunks = single_chunks();
+		double const t_single_records = single_records();
+		double const t_batch_chunks = batch_chunks();
+		double const t_batch_records = batch_records();
+
+		if (pass == 0) {
+			continue;
+		}
+
+		printf("bench_fifo: push + pop of a message: chunk fifo %.1f ns, record fifo %.1f ns\n",
+			t_single_chunks * 1e9, t_single_records * 1e9);
+		printf("bench_fifo: batches of 4 messages:   chunk fifo %.1f ns, record fifo %.1f ns per message\n",
+			t_batch_chunks * 1e9, t_batch_records * 1e9);
+	}
+
+	return 0;
+}
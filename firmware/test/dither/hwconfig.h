@@ -0,0 +1,46 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HWCONFIG_H__INCLUDED
+#define HWCONFIG_H__INCLUDED
+
+// host test configuration of led.c: 8 outputs on port B with the tick engine, the interrupt
+// is called by the test once per 200us tick, the output on pin 7 is inverted, all optional
+// LED commands are built
+
+#define ENABLE_LED_TIMED
+#define ENABLE_LED_FADE
+#define ENABLE_LED_SEQUENCER
+#define ENABLE_LED_SCENE
+
+#define LED_TIMER_vect led_timer_isr
+#define LED_TIMER_OCR OCR0A
+#define LED_TIMER_PRESCALER 64
+
+static void inline led_timer_init(void) {}
+
+#define LED_MAPPING_TABLE(_map_) \
+	_map_( B, 0, 0 ) \
+	_map_( B, 1, 0 ) \
+	_map_( B, 2, 0 ) \
+	_map_( B, 3, 0 ) \
+	_map_( B, 4, 0 ) \
+	_map_( B, 5, 0 ) \
+	_map_( B, 6, 0 ) \
+	_map_( B, 7, 1 ) \
+	/* end */
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HWCONFIG_H__INCLUDED
+#define HWCONFIG_H__INCLUDED
+
+// host test configuration of comm.c: the master end of the arduino_mega2560 data link,
+// test_link.c calls the interrupts and the main loop
+
+#include "../../../arduino_mega2560/devconfig.h"
+
+#define DATA_TX_UART_vect   data_tx_isr
+#define DATA_RX_UART_vect   data_rx_isr
+#define DATA_UART_MASTER
+
+#define SIM_UART_SIDE 0
+#include "../uart.h"
+
+#endif
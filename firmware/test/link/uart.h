@@ -0,0 +1,52 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// host stand-in of the data UART (see data_uart1.h), the registers are in the loopback of
+// test_link.c, SIM_UART_SIDE selects the end of the link
+
+#ifndef SIM_UART_H__INCLUDED
+#define SIM_UART_H__INCLUDED
+
+#include <stdint.h>
+
+void sim_uart_setUDRIE(uint8_t side, uint8_t x);
+void sim_uart_writeUDR(uint8_t side, uint8_t x);
+uint8_t sim_uart_readUDR(uint8_t side);
+void sim_uart_setBIT8TX(uint8_t side, uint8_t x);
+uint8_t sim_uart_getBIT8RX(uint8_t side);
+uint8_t sim_uart_getError(uint8_t side);
+void sim_uart_setRate(uint8_t side, uint8_t ubrr, uint8_t u2x);
+void sim_uart_clearTXC(uint8_t side);
+uint8_t sim_uart_getTXC(uint8_t side);
+
+static void inline uart_setUDRIE(uint8_t x) { sim_uart_setUDRIE(SIM_UART_SIDE, x); }
+static void inline uart_writeUDR(uint8_t x) { sim_uart_writeUDR(SIM_UART_SIDE, x); }
+static uint8_t inline uart_readUDR(void) { return sim_uart_readUDR(SIM_UART_SIDE); }
+static void inline uart_setBIT8TX(uint8_t x) { sim_uart_setBIT8TX(SIM_UART_SIDE, x); }
+static uint8_t inline uart_getBIT8RX(void) { return sim_uart_getBIT8RX(SIM_UART_SIDE); }
+static uint8_t inline uart_getError(void) { return sim_uart_getError(SIM_UART_SIDE); }
+static void inline uart_setRate(uint8_t ubrr, uint8_t u2x) { sim_uart_setRate(SIM_UART_SIDE, ubrr, u2x); }
+static void inline uart_clearTXC(void) { sim_uart_clearTXC(SIM_UART_SIDE); }
+static uint8_t inline uart_getTXC(void) { return sim_uart_getTXC(SIM_UART_SIDE); }
+
+#define UART_ERROR_FE 0x10
+
+static void inline data_uart_init(void)
+{
+	sim_uart_setRate(SIM_UART_SIDE, 3, 0); // 250 kBit/s, the link starts with that rate
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HWCONFIG_H__INCLUDED
+#define HWCONFIG_H__INCLUDED
+
+// host test configuration of led.c: 16 outputs on a chain of two 74HC595 with the BAM engine,
+// test_sr.c clocks the bytes written to SPDR into its model of the chain and takes the latch
+// pulses, LED_SR_INVERTED is set by the makefile for test_sr_inverted
+
+#define LED_PWM_ENGINE LED_PWM_BAM
+#define LED_SR_OUTPUTS 16
+
+#define LED_TIMER_vect led_timer_isr
+#define LED_TIMER_OCR OCR0A
+#define LED_TIMER_PRESCALER 64
+
+static void inline led_timer_init(void) {}
+
+void sim_sr_latch(void);
+
+static void inline led_sr_init(void)
+{
+	SPCR = _BV(SPE) | _BV(MSTR);
+}
+
+static void inline led_sr_latch(void)
+{
+	sim_sr_latch();
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Dithered 8 bit brightness (LED_CMD_BRIGHT): every value 0..255 is set on a plain and on an
+// inverted output, the tick interrupt is run for TEST_PERIODS periods and the time the pins are
+// 'on' must match value / 255 within 1/256. Without the dithering the error would be up to 1/98.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <avr/io.h>
+
+#include "clock.h"
+#include "led.h"
+
+#define MAX_PWM       49     // tick interrupts per period, see led.c
+#define TEST_PERIODS  256
+
+void led_timer_isr(void);
+
+uint16_t clock_ms(void) { return 0; }
+uint32_t clock(void) { return 0; }
+
+static void set_brightness(uint8_t first, uint8_t value)
+{
+	uint8_t const report[4] = { LED_CMD_BRIGHT, first, 1, value };
+	led_update_bright(report, sizeof(report));
+}
+
+int main(void)
+{
+	double max_error = 0;
+	int failed = 0;
+
+	led_init();
+
+	for (int v = 0; v < 256; v++)
+	{
+		set_brightness(0, v);
+		set_brightness(7, 255 - v);
+
+		// the new values are taken over at the start of the next period
+
+		for (int k = 0; k < MAX_PWM; k++) {
+			led_timer_isr();
+		}
+
+		long on0 = 0;
+		long on7 = 0;
+
+		for (long k = 0; k < TEST_PERIODS * MAX_PWM; k++)
+		{
+			led_timer_isr();
+			on0 += (PORTB >> 0) & 0x01;
+			on7 += ((PORTB >> 7) & 0x01) ^ 0x01;
+		}
+
+		double const e0 = (double)on0 / (TEST_PERIODS * MAX_PWM) - v / 255.0;
+		double const e7 = (double)on7 / (TEST_PERIODS * MAX_PWM) - (255 - v) / 255.0;
+
+		if (fabs(e0) > 1.0 / 256 || fabs(e7) > 1.0 / 256)
+		{
+			printf("brightness %3d: duty cycle off by %+.5f (output 0), %+.5f (output 7)\n", v, e0, e7);
+			failed = 1;
+		}
+
+		max_error = fmax(max_error, fmax(fabs(e0), fabs(e7)));
+	}
+
+	printf("test_dither: max. duty cycle error %.6f (limit %.6f) %s\n", max_error, 1.0 / 256, failed ? "FAILED" : "ok");
+
+	return failed;
+}
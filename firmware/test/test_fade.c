@@ -0,0 +1,78 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Fades (LED_CMD_FADE): the outputs ramp from their level to the target, also when the difference is
+// smaller than the number of periods, so the step per period is less than 1/256 level. The on-time
+// of a linear ramp over the fade is half the difference times the fade time.
+// Uses the configuration of test_dither, 8 outputs on port B with the tick engine.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <avr/io.h>
+
+#include "clock.h"
+#include "led.h"
+
+#define MAX_PWM  49     // tick interrupts per period, see led.c
+
+void led_timer_isr(void);
+
+uint16_t clock_ms(void) { return 0; }
+uint32_t clock(void) { return 0; }
+
+// run 'n' periods and count the ticks every output is on
+
+static void run_periods(int n, long *ticks)
+{
+	for (int k = 0; k < n * MAX_PWM; k++)
+	{
+		led_timer_isr();
+
+		uint8_t const on = PORTB ^ 0x80;
+
+		for (int i = 0; i < 8; i++) {
+			ticks[i] += (on >> i) & 0x01;
+		}
+	}
+}
+
+static int check(char const *name, long ticks, long expected)
+{
+	int const failed = labs(ticks - expected) > expected / 50 + 1;
+	printf("test_fade: %-40s on-ticks %6ld (expected %6ld)  %s\n", name, ticks, expected, failed ? "FAILED" : "ok");
+	return failed;
+}
+
+int main(void)
+{
+	int failed = 0;
+	long ticks[8] = { 0 };
+
+	led_init();
+
+	// 10s fades of 0 -> 1 and 0 -> 4 on output 0 and 1, 1020 periods of 9.8ms, then 100 periods at the target
+
+	uint8_t const fade[7] = { LED_CMD_FADE, 10000 & 0xFF, 10000 >> 8, 0, 2, 1, 4 };
+	led_update_fade(fade, sizeof(fade));
+
+	run_periods(1 + 1020 + 100, ticks);
+
+	failed |= check("0 -> 1 in 10s", ticks[0], 510 + 100);
+	failed |= check("0 -> 4 in 10s", ticks[1], 4 * 510 + 4 * 100);
+
+	return failed;
+}
@@ -0,0 +1,448 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Rate negotiation of the data link (DATA_UART_RATE_MAX): comm.c of the master and of the slave
+// are loaded as link_master.so and link_slave.so and talk over a simulated 9 bit UART. A reset
+// of the slave reloads its library, so it starts over with fresh state like the real m2560.
+// Every case runs both ends for a few seconds with messages on all three channels of the link,
+// then checks the rate both ends settled at and that no message was lost in the last second.
+
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+#include "comm.h"
+
+#define STEP_NS       250LL
+#define BOOT_NS       150000000LL  // the m2560 starts after the bootloader
+#define MASTER_LOOP   100000LL     // the main loops call comm_task() this often
+#define SLAVE_LOOP    700000LL
+#define PANEL_NS      2000000LL    // a panel report every 2 ms
+#define BULK_NS       1000000LL    // a bulk message every 1 ms
+#define SECOND_NS     1000000000LL
+
+
+/****************************************
+ simulated UART
+****************************************/
+
+typedef struct {
+	long long bit_ns;
+	uint8_t udrie;
+	uint8_t bit8tx;
+	uint8_t txc;
+	uint8_t tx_full;
+	uint16_t tx_data;
+	uint8_t shifting;
+	uint16_t shift;
+	long long shift_end;
+	long long shift_bit_ns;
+	uint8_t rx_count;
+	uint16_t rx_data[2];
+	uint8_t rx_error[2];
+} sim_uart_t;
+
+static sim_uart_t g_uart[2];
+static long long g_now = 0;
+static double g_error_rate = 0;  // errors per byte at the top rate
+static uint8_t g_running[2] = { 0, 0 };
+
+void sim_uart_setUDRIE(uint8_t side, uint8_t x) { g_uart[side].udrie = x; }
+void sim_uart_setBIT8TX(uint8_t side, uint8_t x) { g_uart[side].bit8tx = x; }
+void sim_uart_clearTXC(uint8_t side) { g_uart[side].txc = 0; }
+uint8_t sim_uart_getTXC(uint8_t side) { return g_uart[side].txc; }
+uint8_t sim_uart_getBIT8RX(uint8_t side) { return g_uart[side].rx_count ? (g_uart[side].rx_data[0] >> 8) & 0x01 : 0; }
+uint8_t sim_uart_getError(uint8_t side) { return g_uart[side].rx_count ? g_uart[side].rx_error[0] : 0; }
+
+void sim_uart_setRate(uint8_t side, uint8_t ubrr, uint8_t u2x)
+{
+	g_uart[side].bit_ns = (u2x ? 8 : 16) * (ubrr + 1) * 125LL / 2;
+}
+
+void sim_uart_writeUDR(uint8_t side, uint8_t x)
+{
+	sim_uart_t *u = &g_uart[side];
+	u->tx_data = x | (u->bit8tx ? 0x100 : 0);
+	u->tx_full = 1;
+	u->txc = 0;
+}
+
+uint8_t sim_uart_readUDR(uint8_t side)
+{
+	sim_uart_t *u = &g_uart[side];
+	uint8_t const x = u->rx_data[0] & 0xFF;
+
+	if (u->rx_count > 0)
+	{
+		u->rx_data[0] = u->rx_data[1];
+		u->rx_error[0] = u->rx_error[1];
+		u->rx_count--;
+	}
+
+	return x;
+}
+
+static void uart_deliver(uint8_t side, uint16_t x, long long bit_ns)
+{
+	sim_uart_t *u = &g_uart[side];
+	uint8_t error = 0;
+
+	if (!g_running[side]) {
+		return;
+	}
+
+	if (bit_ns != u->bit_ns)
+	{
+		error = UART_ERROR_FE; // the receiver is at an other rate
+		x = rand() & 0x1FF;
+	}
+	else if (bit_ns < 600 && rand() < g_error_rate * RAND_MAX)
+	{
+		error = UART_ERROR_FE;
+	}
+
+	if (u->rx_count >= 2)
+	{
+		u->rx_error[1] |= 0x08; // data overrun
+		return;
+	}
+
+	u->rx_data[u->rx_count] = x;
+	u->rx_error[u->rx_count] = error;
+	u->rx_count++;
+}
+
+static void uart_step(uint8_t side)
+{
+	sim_uart_t *u = &g_uart[side];
+
+	if (u->shifting && g_now >= u->shift_end)
+	{
+		uart_deliver(side ^ 1, u->shift, u->shift_bit_ns);
+		u->shifting = 0;
+		u->txc = !u->tx_full;
+	}
+
+	if (!u->shifting && u->tx_full)
+	{
+		u->shifting = 1;
+		u->shift = u->tx_data;
+		u->shift_bit_ns = u->bit_ns;
+		u->shift_end = g_now + 12 * u->bit_ns; // start, 9 data, parity and stop bit
+		u->tx_full = 0;
+	}
+}
+
+static int uart_kbits(uint8_t side)
+{
+	return (int)(1000000LL / g_uart[side].bit_ns);
+}
+
+uint16_t clock_ms(void) { return (uint16_t)(g_now / 1000000LL); }
+uint32_t clock(void) { return (uint32_t)(g_now / 62); }
+
+
+/****************************************
+ the controllers
+****************************************/
+
+typedef struct {
+	void *lib;
+	void (*comm_init)(void);
+	void (*comm_task)(void);
+	msg_t* (*msg_prepare)(uint8_t channel);
+	void (*msg_send)(void);
+	msg_t* (*msg_recv)(void);
+	void (*msg_release)(void);
+	uint8_t (*msg_channel)(void);
+	void (*tx_isr)(void);
+	void (*rx_isr)(void);
+	long long next_loop;
+} controller_t;
+
+static controller_t g_master;
+static controller_t g_slave;
+static long long g_slave_boot = 0;
+
+static void *symbol(void *lib, char const *name)
+{
+	void *p = dlsym(lib, name);
+
+	if (p == NULL)
+	{
+		fprintf(stderr, "test_link: %s\n", dlerror());
+		exit(2);
+	}
+
+	return p;
+}
+
+static void controller_load(controller_t *c, char const *path)
+{
+	memset(c, 0, sizeof(*c));
+
+	c->lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+
+	if (c->lib == NULL)
+	{
+		fprintf(stderr, "test_link: %s\n", dlerror());
+		exit(2);
+	}
+
+	*(void**)&c->comm_init = symbol(c->lib, "comm_init");
+	*(void**)&c->comm_task = symbol(c->lib, "comm_task");
+	*(void**)&c->msg_prepare = symbol(c->lib, "msg_prepare");
+	*(void**)&c->msg_send = symbol(c->lib, "msg_send");
+	*(void**)&c->msg_recv = symbol(c->lib, "msg_recv");
+	*(void**)&c->msg_release = symbol(c->lib, "msg_release");
+	*(void**)&c->msg_channel = symbol(c->lib, "msg_channel");
+	*(void**)&c->tx_isr = symbol(c->lib, "data_tx_isr");
+	*(void**)&c->rx_isr = symbol(c->lib, "data_rx_isr");
+}
+
+static void controller_unload(controller_t *c)
+{
+	if (c->lib != NULL) {
+		dlclose(c->lib);
+	}
+
+	memset(c, 0, sizeof(*c));
+}
+
+static void controller_step(controller_t *c, uint8_t side, long long loop_ns)
+{
+	if (g_uart[side].udrie && !g_uart[side].tx_full) {
+		c->tx_isr();
+	}
+
+	if (g_uart[side].rx_count) {
+		c->rx_isr();
+	}
+
+	if (g_now >= c->next_loop)
+	{
+		c->comm_task();
+		c->next_loop = g_now + loop_ns;
+	}
+}
+
+static void slave_reset(void)
+{
+	controller_unload(&g_slave);
+	memset(&g_uart[1], 0, sizeof(g_uart[1]));
+	g_running[1] = 0;
+	g_slave_boot = g_now + BOOT_NS;
+}
+
+
+/****************************************
+ traffic
+****************************************/
+
+// the master sends numbered LED messages as fast as the link takes them, the slave sends a numbered
+// panel report every PANEL_NS and a bulk message of 2..MSG_MAXLEN bytes every BULK_NS
+
+typedef struct {
+	uint16_t sent;
+	uint16_t next;
+	long received;
+	long lost;
+} stream_t;
+
+static stream_t g_led, g_panel, g_bulk;
+static long long g_panel_due, g_bulk_due;
+
+static void stream_send(stream_t *s, msg_t *p, uint8_t nlen)
+{
+	p->nlen = nlen;
+	memset(p->data, 0, nlen);
+	p->data[0] = s->sent & 0xFF;
+	p->data[1] = s->sent >> 8;
+	s->sent++;
+}
+
+static void stream_recv(stream_t *s, msg_t const *p)
+{
+	uint16_t const seq = p->data[0] | (p->data[1] << 8);
+	s->lost += (uint16_t)(seq - s->next);
+	s->next = seq + 1;
+	s->received++;
+}
+
+static void traffic_step(void)
+{
+	msg_t *p;
+
+	while ((p = g_master.msg_prepare(MSG_CHANNEL_LED)) != NULL)
+	{
+		stream_send(&g_led, p, 8);
+		g_master.msg_send();
+	}
+
+	while ((p = g_master.msg_recv()) != NULL)
+	{
+		stream_recv((g_master.msg_channel() == MSG_CHANNEL_BULK) ? &g_bulk : &g_panel, p);
+		g_master.msg_release();
+	}
+
+	if (!g_running[1]) {
+		return;
+	}
+
+	if (g_now >= g_panel_due && (p = g_slave.msg_prepare(MSG_CHANNEL_PANEL)) != NULL)
+	{
+		stream_send(&g_panel, p, 5);
+		g_slave.msg_send();
+		g_panel_due = g_now + PANEL_NS;
+	}
+
+	if (g_now >= g_bulk_due && (p = g_slave.msg_prepare(MSG_CHANNEL_BULK)) != NULL)
+	{
+		stream_send(&g_bulk, p, 2 + g_bulk.sent % (MSG_MAXLEN - 1));
+		g_slave.msg_send();
+		g_bulk_due = g_now + BULK_NS;
+	}
+
+	while ((p = g_slave.msg_recv()) != NULL)
+	{
+		stream_recv(&g_led, p);
+		g_slave.msg_release();
+	}
+}
+
+
+/****************************************
+ test cases
+****************************************/
+
+static void run_until(long long t)
+{
+	for (; g_now < t; g_now += STEP_NS)
+	{
+		if (!g_running[1] && g_now >= g_slave_boot)
+		{
+			controller_load(&g_slave, "./link_slave.so");
+			g_slave.comm_init();
+			g_running[1] = 1;
+			g_panel.next = g_panel.sent; // the messages queued before the reset are gone
+			g_bulk.next = g_bulk.sent;
+		}
+
+		uart_step(0);
+		uart_step(1);
+
+		controller_step(&g_master, 0, MASTER_LOOP);
+
+		if (g_running[1]) {
+			controller_step(&g_slave, 1, SLAVE_LOOP);
+		}
+
+		traffic_step();
+	}
+}
+
+static void start(double error_rate)
+{
+	controller_unload(&g_master);
+	controller_unload(&g_slave);
+	memset(g_uart, 0, sizeof(g_uart));
+
+	g_now = 0;
+	g_error_rate = error_rate;
+	g_running[0] = 1;
+	g_running[1] = 0;
+	g_slave_boot = BOOT_NS;
+
+	memset(&g_led, 0, sizeof(g_led));
+	memset(&g_panel, 0, sizeof(g_panel));
+	memset(&g_bulk, 0, sizeof(g_bulk));
+	g_panel_due = 0;
+	g_bulk_due = 0;
+
+	srand(1);
+
+	controller_load(&g_master, "./link_master.so");
+	g_master.comm_init();
+}
+
+// runs the last second and checks that both ends are at the expected rate and that
+// the messages of all channels in that second made it
+
+static int finish(char const *name, int kbits)
+{
+	run_until(g_now + SECOND_NS);
+
+	stream_t const led = g_led;
+	stream_t const panel = g_panel;
+	stream_t const bulk = g_bulk;
+
+	run_until(g_now + SECOND_NS);
+
+	long const leds = g_led.received - led.received;
+	long const panels = g_panel.received - panel.received;
+	long const bulks = g_bulk.received - bulk.received;
+	long const lost = (g_led.lost - led.lost) + (g_panel.lost - panel.lost) + (g_bulk.lost - bulk.lost);
+
+	int const ok = uart_kbits(0) == kbits && uart_kbits(1) == kbits &&
+		leds > 0 && panels > 0 && bulks > 0 && lost == 0;
+
+	printf("test_link: %-28s master %4d kBit/s, slave %4d kBit/s (expected %4d), messages/s %5ld LED %3ld panel %4ld bulk, lost %ld  %s\n",
+		name, uart_kbits(0), uart_kbits(1), kbits, leds, panels, bulks, lost, ok ? "ok" : "FAILED");
+
+	return !ok;
+}
+
+int main(void)
+{
+	int failed = 0;
+
+	// both ends negotiate the top rate
+
+	start(0);
+	run_until(2 * SECOND_NS);
+	failed |= finish("clean link", 2000);
+
+	// the top rate does not work, the master has to settle one rate below
+
+	start(0.01);
+	run_until(3 * SECOND_NS);
+	failed |= finish("top rate unreliable", 1000);
+
+	// a reset of the slave after the link ran well for a while must not lower
+	// the rate for the rest of the session
+
+	start(0);
+	run_until(3 * SECOND_NS);
+	slave_reset();
+	run_until(6 * SECOND_NS);
+	failed |= finish("slave reset", 2000);
+
+	// the same with an unreliable top rate, the master tries it once more after the reset
+
+	start(0.01);
+	run_until(3 * SECOND_NS);
+	slave_reset();
+	run_until(6 * SECOND_NS);
+	failed |= finish("slave reset, top unreliable", 1000);
+
+	controller_unload(&g_master);
+	controller_unload(&g_slave);
+
+	return failed;
+}
@@ -0,0 +1,241 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Bitstream of the 74HC595 chain (LED_SR_OUTPUTS): the bytes that led.c writes to SPDR are clocked
+// MSB first into a model of two registers, the latch pulse copies them to the output pins. Checked are
+// the position of every output in the chain, the time between the latch pulses of the six BAM planes
+// and the on-time of the outputs over a period. test_sr_inverted is the same test with LED_SR_INVERTED,
+// where an output is on while its pin is low.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <hwconfig.h>
+
+#include "clock.h"
+#include "led.h"
+
+#if defined(LED_SR_INVERTED)
+	#define TEST_NAME "test_sr_inverted"
+	#define PIN_LEVEL(on) (!(on))
+#else
+	#define TEST_NAME "test_sr"
+	#define PIN_LEVEL(on) (on)
+#endif
+
+#define REGISTERS     (LED_SR_OUTPUTS / 8)
+#define PLANES        6
+#define UNIT_TICKS    39   // timer ticks of the least significant plane, 9.8ms / 63 at 16 MHz / 64
+#define PERIOD_TICKS  (UNIT_TICKS * ((1 << PLANES) - 1))
+
+void led_timer_isr(void);
+
+uint16_t clock_ms(void) { return 0; }
+uint32_t clock(void) { return 0; }
+
+static uint8_t g_shift[REGISTERS];  // shift stage, [0] is the register at MOSI
+static uint8_t g_pins[REGISTERS];   // storage stage, the output pins
+static long g_now = 0;              // timer ticks
+static long g_latch_time[4 * PLANES];
+static int g_latches = 0;
+
+uint8_t sim_spsr(void)
+{
+	// the byte in SPDR is clocked out, Q7' of each register feeds SER of the next one
+
+	uint8_t const x = SPDR;
+
+	for (int8_t b = 7; b >= 0; b--)
+	{
+		for (uint8_t k = REGISTERS - 1; k > 0; k--) {
+			g_shift[k] = (g_shift[k] << 1) | (g_shift[k - 1] >> 7);
+		}
+
+		g_shift[0] = (g_shift[0] << 1) | ((x >> b) & 0x01);
+	}
+
+	return _BV(SPIF);
+}
+
+void sim_sr_latch(void)
+{
+	memcpy(g_pins, g_shift, sizeof(g_pins));
+
+	if (g_latches < (int)(sizeof(g_latch_time) / sizeof(g_latch_time[0]))) {
+		g_latch_time[g_latches++] = g_now;
+	}
+}
+
+static uint8_t output_on(uint8_t i)
+{
+	return PIN_LEVEL((g_pins[i >> 3] >> (i & 0x07)) & 0x01);
+}
+
+// plane weights of a profile 0..49, that is round(x * 63 / 49)
+
+static long expected_ticks(uint8_t profile)
+{
+	return (((long)profile * 63 + 24) / 49) * UNIT_TICKS;
+}
+
+static void set_profiles(uint8_t const *profiles)
+{
+	uint8_t report[2 + 2 * LED_SR_OUTPUTS] = { LED_CMD_DELTA, LED_SR_OUTPUTS };
+
+	for (uint8_t i = 0; i < LED_SR_OUTPUTS; i++)
+	{
+		report[2 + 2 * i] = i | (profiles[i] ? LED_DELTA_ENABLE : 0);
+		report[3 + 2 * i] = profiles[i] ? profiles[i] : 1;
+	}
+
+	led_update_delta(report, sizeof(report));
+}
+
+// runs the timer interrupt for whole periods, the compare value it programs is the time to the next call
+
+static void run(int periods, long *on_ticks)
+{
+	long const t_end = g_now + (long)periods * PERIOD_TICKS;
+
+	if (on_ticks != NULL) {
+		memset(on_ticks, 0, LED_SR_OUTPUTS * sizeof(on_ticks[0]));
+	}
+
+	g_latches = 0;
+
+	while (g_now < t_end)
+	{
+		led_timer_isr();
+
+		long const dt = OCR0A + 1;
+
+		if (on_ticks != NULL) {
+			for (uint8_t i = 0; i < LED_SR_OUTPUTS; i++) {
+				on_ticks[i] += output_on(i) ? dt : 0;
+			}
+		}
+
+		g_now += dt;
+	}
+}
+
+// a single output at full brightness has to show up at Q(i & 7) of register (i >> 3) in every plane
+
+static int test_bit_order(void)
+{
+	int failed = 0;
+
+	for (uint8_t i = 0; i < LED_SR_OUTPUTS; i++)
+	{
+		uint8_t profiles[LED_SR_OUTPUTS] = { 0 };
+		profiles[i] = 49;
+		set_profiles(profiles);
+		run(2, NULL);
+
+		long on[LED_SR_OUTPUTS];
+		run(1, on);
+
+		for (uint8_t k = 0; k < REGISTERS; k++)
+		{
+			uint8_t const expected = (k == (i >> 3)) ? _BV(i & 0x07) : 0x00;
+			uint8_t const pins = PIN_LEVEL(0) ? (uint8_t)~expected : expected;
+
+			if (g_pins[k] != pins)
+			{
+				printf("output %2d: register %d pins 0x%02X, expected 0x%02X\n", i, k, g_pins[k], pins);
+				failed = 1;
+			}
+		}
+
+		for (uint8_t j = 0; j < LED_SR_OUTPUTS; j++)
+		{
+			if (on[j] != ((j == i) ? PERIOD_TICKS : 0))
+			{
+				printf("output %2d: output %2d on for %ld ticks of %d\n", i, j, on[j], PERIOD_TICKS);
+				failed = 1;
+			}
+		}
+	}
+
+	printf(TEST_NAME ": bit order %s\n", failed ? "FAILED" : "ok");
+
+	return failed;
+}
+
+// every output has an other profile, the on-time over a period has to be the sum of the
+// weights of its planes, and the planes have to be latched UNIT_TICKS << plane apart
+
+static int test_timing(void)
+{
+	static uint8_t const profiles[LED_SR_OUTPUTS] = { 0, 1, 2, 3, 5, 8, 13, 20, 25, 30, 36, 40, 45, 47, 48, 49 };
+	int failed = 0;
+
+	set_profiles(profiles);
+	run(2, NULL);
+
+	long on[LED_SR_OUTPUTS];
+	run(2, on);
+
+	for (uint8_t i = 0; i < LED_SR_OUTPUTS; i++)
+	{
+		if (on[i] != 2 * expected_ticks(profiles[i]))
+		{
+			printf("output %2d, profile %2d: on for %ld ticks, expected %ld\n", i, profiles[i], on[i], 2 * expected_ticks(profiles[i]));
+			failed = 1;
+		}
+	}
+
+	if (g_latches != 2 * PLANES)
+	{
+		printf("%d latch pulses in 2 periods, expected %d\n", g_latches, 2 * PLANES);
+		failed = 1;
+	}
+
+	int first = 0;
+
+	while (first < g_latches - 1 && g_latch_time[first + 1] - g_latch_time[first] != UNIT_TICKS) {
+		first++;
+	}
+
+	for (int k = first; k < g_latches - 1; k++)
+	{
+		long const dt = g_latch_time[k + 1] - g_latch_time[k];
+		long const expected = (long)UNIT_TICKS << ((k - first) % PLANES);
+
+		if (dt != expected)
+		{
+			printf("latch pulse %d: %ld ticks after the previous one, expected %ld\n", k + 1, dt, expected);
+			failed = 1;
+		}
+	}
+
+	printf(TEST_NAME ": plane timing and duty cycle %s\n", failed ? "FAILED" : "ok");
+
+	return failed;
+}
+
+int main(void)
+{
+	int failed = 0;
+
+	led_init();
+
+	failed |= test_bit_order();
+	failed |= test_timing();
+
+	return failed;
+}
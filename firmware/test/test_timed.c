@@ -0,0 +1,120 @@
+/*
+ * LWCloneU2
+ * Copyright (C) 2013 Andreas Dittrich <lwcloneu2@cithraidt.de>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program;
+ * if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Timed updates (LED_CMD_TIMED) and open PBA sequences: a timed update that falls due while a
+// plain PBA sequence or a split LED_CMD_PBA update is not complete must not commit the part that
+// has been received so far. It is shown together with the rest of the sequence once that arrives.
+// Uses the configuration of test_dither, 8 outputs on port B with the tick engine.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <avr/io.h>
+
+#include "clock.h"
+#include "led.h"
+
+#define MAX_PWM  49     // tick interrupts per period, see led.c
+
+void led_timer_isr(void);
+
+static uint16_t g_now = 0;
+
+uint16_t clock_ms(void) { return g_now; }
+uint32_t clock(void) { return 0; }
+
+// run 'n' periods and return the outputs that were 'on' during the whole last one
+
+static uint8_t run_periods(int n)
+{
+	uint8_t on = 0xFF;
+
+	for (int k = 0; k < n * MAX_PWM; k++)
+	{
+		led_timer_isr();
+		g_now += 1;   // a little fast, 200us per tick would be exact
+
+		if (k >= (n - 1) * MAX_PWM) {
+			on &= PORTB ^ 0x80;
+		}
+	}
+
+	return on;
+}
+
+static void send(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t b4, uint8_t b5, uint8_t b6, uint8_t b7)
+{
+	uint8_t report[8] = { b0, b1, b2, b3, b4, b5, b6, b7 };
+	led_update(0, report);
+}
+
+static void send_timed(uint8_t output, uint8_t profile)
+{
+	uint8_t const report[6] = { LED_CMD_TIMED, g_now & 0xFF, g_now >> 8, 1, output | LED_DELTA_ENABLE, profile };
+	led_update_timed(report, sizeof(report));
+}
+
+static int check(char const *name, uint8_t on, uint8_t expected)
+{
+	int const failed = (on != expected);
+	printf("test_timed: %-48s outputs 0x%02X (expected 0x%02X)  %s\n", name, on, expected, failed ? "FAILED" : "ok");
+	return failed;
+}
+
+int main(void)
+{
+	int failed = 0;
+
+	led_init();
+
+	// all outputs switched on at brightness 0, then a complete PBA sequence
+
+	send(64, 0xFF, 0xFF, 0xFF, 0xFF, 2, 0, 0);
+	send(0, 0, 0, 0, 0, 0, 0, 0);
+	send(0, 0, 0, 0, 0, 0, 0, 0);
+	send(0, 0, 0, 0, 0, 0, 0, 0);
+	send(0, 0, 0, 0, 0, 0, 0, 0);
+	failed |= check("start", run_periods(3), 0x00);
+
+	// plain PBA: the first bank is received, then output 1 falls due
+
+	send(MAX_PWM, 0, 0, 0, 0, 0, 0, 0);
+	send_timed(1, MAX_PWM);
+	failed |= check("plain PBA open, timed update due", run_periods(3), 0x00);
+
+	send(0, 0, 0, 0, 0, 0, 0, 0);
+	send(0, 0, 0, 0, 0, 0, 0, 0);
+	send(0, 0, 0, 0, 0, 0, 0, 0);
+	failed |= check("plain PBA complete", run_periods(3), 0x03);
+
+	// LED_CMD_PBA split into two reports, output 3 falls due in between
+
+	uint8_t const first[4] = { LED_CMD_PBA, 2, 1, MAX_PWM };
+	uint8_t const last[4] = { LED_CMD_PBA, 4, 1 | LED_PBA_COMMIT, MAX_PWM };
+
+	led_update_pba(first, sizeof(first));
+	send_timed(3, MAX_PWM);
+	failed |= check("LED_CMD_PBA open, timed update due", run_periods(3), 0x03);
+
+	led_update_pba(last, sizeof(last));
+	failed |= check("LED_CMD_PBA committed", run_periods(3), 0x1F);
+
+	// without an open sequence the timed update is shown right away
+
+	send_timed(5, MAX_PWM);
+	failed |= check("no sequence open", run_periods(3), 0x3F);
+
+	return failed;
+}
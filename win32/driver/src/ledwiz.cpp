@@ -15,6 +15,7 @@
  */
 
 #include <string.h>
+#include <math.h>
 
 #include <windows.h>
 #include <crtdbg.h>
@@ -41,9 +42,35 @@ USHORT const ProductID_LEDWiz_max  = ProductID_LEDWiz_min + LWZ_MAX_DEVICES - 1;
 
 static const char * lwz_process_sync_mutex_name = "lwz_process_sync_mutex";
 
+// extended LWCloneU2 commands, see firmware/led.h
+// [LWZ_CMD_DELTA, count, (output | LWZ_DELTA_ENABLE, profile) * count], up to 3 entries per report
+// [LWZ_CMD_PBA, first, count, profile * count], up to 5 profiles per report, the profiles are shown
+// with the report that has LWZ_PBA_COMMIT in the count byte
+
+BYTE const LWZ_CMD_DELTA = 0x44;
+BYTE const LWZ_DELTA_ENABLE = 0x80;
+BYTE const LWZ_CMD_PBA = 0x4C;
+BYTE const LWZ_PBA_COMMIT = 0x80;
+int const LWZ_PBA_PROFILES = 5;
+
+// [LWZ_CMD_PHASE, phase_lo, phase_hi], the phase of the pulse modes advances by 128 every 9.8ms,
+// all devices get the phase of the same host clock once per second and pulse in step
+
+BYTE const LWZ_CMD_PHASE = 0x4D;
+DWORD const LWZ_PHASE_INTERVAL_MS = 1000;
+double const LWZ_PHASE_CYCLE_S = 512 * 0.0098;
+
 typedef struct {
 	HUDEV hudev;
 	DWORD dat[256];
+	bool extended;        // the device understands the extended LWCloneU2 commands
+	bool indexed;         // the device understands LWZ_CMD_PBA, profiles with an explicit output index
+	bool phase;           // the device takes LWZ_CMD_PHASE references for its pulse modes
+	int unit;             // LedWiz unit of a board with several units, its outputs start at unit * 32
+	bool state_valid;     // 'state' is what was sent with the last SBA
+	bool profile_valid;   // 'profile' is what was sent with the last PBA
+	BYTE state[4];
+	BYTE profile[32];
 } lwz_device_t;
 
 typedef void * HQUEUE;
@@ -60,6 +87,10 @@ typedef struct
 	HQUEUE hqueue;
 	#endif
 
+	HANDLE hphasethread;
+	HANDLE hphasestop;
+	HANDLE hphasedone;
+
 	struct {
 		void * puser;
 		LWZNOTIFYPROC notify;
@@ -91,6 +122,10 @@ static void lwz_refreshlist_detached(lwz_context_t *h);
 static void lwz_freelist(lwz_context_t *h);
 static void lwz_add(lwz_context_t *h, int indx);
 static void lwz_remove(lwz_context_t *h, int indx);
+static int lwz_version(HUDEV hudev);
+static int lwz_pba_indexed(lwz_device_t const *pdev, BYTE const *pbrightness_32bytes, BYTE *pdata);
+static void lwz_send_phase(lwz_context_t *h);
+static DWORD WINAPI PhaseThreadProc(LPVOID lpParameter);
 
 static void queue_close(HQUEUE hqueue, bool unload);
 static HQUEUE queue_open(void);
@@ -131,6 +166,14 @@ void LWZ_SBA(
 		return;
 	}
 
+	lwz_device_t * const pdev = &g_plwz->devices[indx];
+
+	pdev->state[0] = bank0;
+	pdev->state[1] = bank1;
+	pdev->state[2] = bank2;
+	pdev->state[3] = bank3;
+	pdev->state_valid = true;
+
 	BYTE data[8];
 	data[0] = 0x40; // LWZ_SBA command identifier
 	data[1] = bank0;
@@ -168,6 +211,116 @@ void LWZ_PBA(LWZHANDLE hlwz, BYTE const *pbrightness_32bytes)
 		return;
 	}
 
+	lwz_device_t * const pdev = &g_plwz->devices[indx];
+
+	// a board with several units takes the extended commands only on unit 0, with the output
+	// numbers of the board
+
+	HUDEV const hcmd = lwz_get_hdev(g_plwz, indx - pdev->unit);
+
+	// if the device knows the delta command and only a few outputs changed,
+	// send just those instead of the four PBA reports
+
+	if (hcmd != NULL &&
+	    pdev->extended &&
+	    pdev->state_valid &&
+	    pdev->profile_valid)
+	{
+		BYTE data[32];
+		int ndata = 0;
+		int nchanged = 0;
+
+		for (int i = 0; i < 32; i++)
+		{
+			if (pbrightness_32bytes[i] != pdev->profile[i])
+				nchanged++;
+		}
+
+		if (nchanged == 0)
+			return;
+
+		// the device commits every delta report on its own, so an update that takes several of
+		// them is only sent as deltas to a device without LWZ_CMD_PBA, the indexed reports of an
+		// update are committed together with the last one
+
+		if (nchanged <= 3 || (nchanged <= 9 && !pdev->indexed))
+		{
+			memset(data, 0x00, sizeof(data));
+
+			for (int i = 0; i < 32; i++)
+			{
+				if (pbrightness_32bytes[i] == pdev->profile[i])
+					continue;
+
+				if ((ndata % 8) == 0)
+				{
+					data[ndata + 0] = LWZ_CMD_DELTA;
+					data[ndata + 1] = 0;
+					ndata += 2;
+				}
+
+				BYTE const enable = (pdev->state[i / 8] >> (i % 8)) & 0x01;
+
+				data[ndata + 0] = (BYTE)(pdev->unit * 32 + i) | (enable ? LWZ_DELTA_ENABLE : 0);
+				data[ndata + 1] = pbrightness_32bytes[i];
+				data[(ndata & ~7) + 1] += 1;
+				ndata += 2;
+			}
+
+			ndata = (ndata + 7) & ~7;
+
+			memcpy(pdev->profile, pbrightness_32bytes, 32);
+
+			#if defined(USE_SEPERATE_IO_THREAD)
+
+			queue_push(g_plwz->hqueue, hcmd, &data[0], ndata);
+
+			#else
+
+			usbdev_write(hcmd, &data[0], ndata);
+
+			#endif
+
+			return;
+		}
+	}
+
+	// a plain PBA report goes to the bank after the previous one, a single lost report mixes up the
+	// banks until the next SBA, with an explicit output index this can not happen and only the
+	// changed outputs need to be sent
+
+	if (hcmd != NULL && pdev->indexed)
+	{
+		BYTE data[8 * ((32 + LWZ_PBA_PROFILES - 1) / LWZ_PBA_PROFILES)];
+
+		int const ndata = lwz_pba_indexed(pdev, pbrightness_32bytes, &data[0]);
+
+		memcpy(pdev->profile, pbrightness_32bytes, 32);
+		pdev->profile_valid = true;
+
+		// a write takes at most 32 bytes, i.e. four reports
+
+		for (int k = 0; k < ndata; k += 32)
+		{
+			int const n = (ndata - k > 32) ? 32 : ndata - k;
+
+			#if defined(USE_SEPERATE_IO_THREAD)
+
+			queue_push(g_plwz->hqueue, hcmd, &data[k], n);
+
+			#else
+
+			usbdev_write(hcmd, &data[k], n);
+
+			#endif
+		}
+
+		return;
+	}
+
+	memcpy(pdev->profile, pbrightness_32bytes, 32);
+	pdev->profile_valid = true;
+
 	#if defined(USE_SEPERATE_IO_THREAD)
 
 	queue_push(g_plwz->hqueue, hudev, pbrightness_32bytes, 32);
@@ -197,6 +350,11 @@ DWORD LWZ_RAWWRITE(LWZHANDLE hlwz, BYTE const *pdata, DWORD ndata)
 		return 0;
 	}
 
+	// we do not know what the raw data does to the outputs
+
+	g_plwz->devices[indx].state_valid = false;
+	g_plwz->devices[indx].profile_valid = false;
+
 	int res = 0;
 	DWORD nbyteswritten = 0;
 
@@ -397,6 +555,15 @@ static lwz_context_t * lwz_open(HINSTANCE hinstDLL)
 	}
 	#endif
 
+	// without the phase references the devices just free-run, so a failure here is not fatal
+
+	h->hphasestop = CreateEvent(NULL, TRUE, FALSE, NULL);
+	h->hphasedone = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+	if (h->hphasestop != NULL && h->hphasedone != NULL) {
+		h->hphasethread = CreateThread(NULL, 0, PhaseThreadProc, (void*)h, 0, NULL);
+	}
+
 	return h;
 }
 
@@ -411,6 +578,29 @@ static void lwz_close(lwz_context_t *h)
 	lwz_freelist(h);
 	lwz_register(h, 0, NULL);
 
+	// like the queue thread, we sync with the 'hphasedone' event and not with
+	// the thread itself because we may be called within the DLL unload
+
+	if (h->hphasethread != NULL)
+	{
+		SetEvent(h->hphasestop);
+		WaitForSingleObject(h->hphasedone, INFINITE);
+		CloseHandle(h->hphasethread);
+		h->hphasethread = NULL;
+	}
+
+	if (h->hphasestop != NULL)
+	{
+		CloseHandle(h->hphasestop);
+		h->hphasestop = NULL;
+	}
+
+	if (h->hphasedone != NULL)
+	{
+		CloseHandle(h->hphasedone);
+		h->hphasedone = NULL;
+	}
+
 	#if defined(USE_SEPERATE_IO_THREAD)
 	if (h->hqueue != NULL)
 	{
@@ -677,11 +867,11 @@ static void lwz_refreshlist_attached(lwz_context_t *h)
 			// if this is the VID/PID we are interested in
 			// check some additional properties
 
-			int indx = (int)attrib.ProductID - (int)ProductID_LEDWiz_min;
+			int const indx_base = (int)attrib.ProductID - (int)ProductID_LEDWiz_min;
 
 			if (bSuccess && 
 			    attrib.VendorID == VendorID_LEDWiz &&
-			    indx >= 0 && indx < LWZ_MAX_DEVICES)
+			    indx_base >= 0 && indx_base < LWZ_MAX_DEVICES)
 			{
 				PHIDP_PREPARSED_DATA p_prepdata = NULL;
 
@@ -691,15 +881,39 @@ static void lwz_refreshlist_attached(lwz_context_t *h)
 
 					if (HIDP_STATUS_SUCCESS == HidP_GetCaps(p_prepdata, &caps))
 					{
+						// a LWCloneU2 with several LedWiz units has a collection for each of them,
+						// the report ID is the unit + 1 and the unit has the ID of the board + unit
+
+						HIDP_VALUE_CAPS vcaps = {};
+						USHORT nvcaps = 1;
+						BYTE reportid = 0;
+
+						if (HIDP_STATUS_SUCCESS == HidP_GetValueCaps(HidP_Output, &vcaps, &nvcaps, p_prepdata) && nvcaps == 1) {
+							reportid = vcaps.ReportID;
+						}
+
+						int const unit = (reportid > 0) ? reportid - 1 : 0;
+						int const indx = indx_base + unit;
+
 						// LED-wiz has an interface with a eight byte report 
 						// (report-id is zero and is not transmitted, but counts here
-						// for the total length)
+						// for the total length, a LWCloneU2 unit sends its report-id)
 
 						if (caps.NumberLinkCollectionNodes == 1 &&
-							caps.OutputReportByteLength == 9)
+							caps.OutputReportByteLength == 9 &&
+							indx < LWZ_MAX_DEVICES)
 						{
 							if (h->devices[indx].hudev == NULL)
 							{
+								usbdev_set_reportid(device_tmp.hudev, reportid);
+
+								int const version = lwz_version(device_tmp.hudev);
+
+								device_tmp.extended = (version >= 2);
+								device_tmp.indexed = (version >= 3);
+								device_tmp.phase = (version >= 4);
+								device_tmp.unit = unit;
+
 								memcpy(&h->devices[indx], &device_tmp, sizeof(device_tmp));
 								device_tmp.hudev = NULL;
 
@@ -728,6 +942,125 @@ static void lwz_refreshlist_attached(lwz_context_t *h)
 	}
 }
 
+// LWCloneU2 devices report "LWC-vvvv-..." as serial number, starting with version 2 they
+// understand the extended commands, with version 3 LWZ_CMD_PBA, returns 0 for other devices
+
+static int lwz_version(HUDEV hudev)
+{
+	WCHAR serial[64] = {};
+
+	if (HidD_GetSerialNumberString(usbdev_handle(hudev), &serial[0], sizeof(serial) - sizeof(WCHAR)) != TRUE)
+		return 0;
+
+	if (wcsncmp(&serial[0], L"LWC-", 4) != 0)
+		return 0;
+
+	int version = 0;
+
+	for (int i = 4; i < 8; i++)
+	{
+		if (serial[i] < L'0' || serial[i] > L'9')
+			return 0;
+
+		version = version * 10 + (serial[i] - L'0');
+	}
+
+	return version;
+}
+
+// build the LWZ_CMD_PBA reports for the outputs that differ from the last PBA, every report starts
+// at a changed output and takes the following ones with it, only the last report commits the update,
+// returns the number of bytes
+
+static int lwz_pba_indexed(lwz_device_t const *pdev, BYTE const *pbrightness_32bytes, BYTE *pdata)
+{
+	int ndata = 0;
+
+	for (int i = 0; i < 32; )
+	{
+		if (pdev->profile_valid && pbrightness_32bytes[i] == pdev->profile[i])
+		{
+			i++;
+			continue;
+		}
+
+		int const n = (32 - i < LWZ_PBA_PROFILES) ? 32 - i : LWZ_PBA_PROFILES;
+
+		memset(&pdata[ndata], 0x00, 8);
+		pdata[ndata + 0] = LWZ_CMD_PBA;
+		pdata[ndata + 1] = (BYTE)(pdev->unit * 32 + i);
+		pdata[ndata + 2] = (BYTE)n;
+		memcpy(&pdata[ndata + 3], &pbrightness_32bytes[i], n);
+
+		ndata += 8;
+		i += n;
+	}
+
+	if (ndata > 0) {
+		pdata[ndata - 8 + 2] |= LWZ_PBA_COMMIT;
+	}
+
+	return ndata;
+}
+
+// send the phase of the host clock to all devices that take it, once per board and not per unit
+
+static void lwz_send_phase(lwz_context_t *h)
+{
+	LARGE_INTEGER freq;
+	LARGE_INTEGER count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	double const s = fmod((double)count.QuadPart / (double)freq.QuadPart, LWZ_PHASE_CYCLE_S);
+	WORD const phase = (WORD)(s * (65536.0 / LWZ_PHASE_CYCLE_S));
+
+	for (int indx = 0; indx < LWZ_MAX_DEVICES; indx++)
+	{
+		lwz_device_t const * const pdev = &h->devices[indx];
+
+		if (pdev->hudev == NULL || !pdev->phase || pdev->unit != 0)
+			continue;
+
+		BYTE data[8] = {};
+		data[0] = LWZ_CMD_PHASE;
+		data[1] = (BYTE)(phase & 0xFF);
+		data[2] = (BYTE)(phase >> 8);
+
+		#if defined(USE_SEPERATE_IO_THREAD)
+
+		queue_push(h->hqueue, pdev->hudev, &data[0], 8);
+
+		#else
+
+		usbdev_write(pdev->hudev, &data[0], 8);
+
+		#endif
+	}
+}
+
+static DWORD WINAPI PhaseThreadProc(LPVOID lpParameter)
+{
+	lwz_context_t * const h = (lwz_context_t*)lpParameter;
+
+	while (WaitForSingleObject(h->hphasestop, LWZ_PHASE_INTERVAL_MS) == WAIT_TIMEOUT)
+	{
+		// lwz_close() holds 'g_cs' while it waits for us, so do not block on it
+
+		if (TryEnterCriticalSection(&g_cs) != TRUE)
+			continue;
+
+		lwz_send_phase(h);
+
+		LeaveCriticalSection(&g_cs);
+	}
+
+	SetEvent(h->hphasedone);
+
+	return 0;
+}
+
 static void lwz_freelist(lwz_context_t *h)
 {
 	for (int i = 0; i < LWZ_MAX_DEVICES; i++)
@@ -42,6 +42,7 @@ typedef struct {
 	HANDLE hwevent;
 	HANDLE hdev;
 	LONG refcount;
+	BYTE reportid;
 } usbdev_context_t;
 
 
@@ -156,6 +157,18 @@ HANDLE usbdev_handle(HUDEV hudev)
 	return h->hdev;
 }
 
+// the report ID that is sent in front of each report, zero if the device does not use report IDs
+
+void usbdev_set_reportid(HUDEV hudev, BYTE reportid)
+{
+	usbdev_context_t * const h = (usbdev_context_t*)hudev;
+
+	if (h != NULL)
+	{
+		h->reportid = reportid;
+	}
+}
+
 size_t usbdev_read(HUDEV hudev, void *psrc, size_t ndata)
 {
 	usbdev_context_t * const h = (usbdev_context_t*)hudev;
@@ -247,7 +260,7 @@ size_t usbdev_write(HUDEV hudev, void const *pdst, size_t ndata)
 	DWORD nbyteswritten = 0;
 
 	BYTE buf[9]; 
-	buf[0] = 0; // report id
+	buf[0] = h->reportid;
 
 	while (ndata > 0)
 	{
@@ -26,6 +26,7 @@ void usbdev_release(HUDEV hudev);
 size_t usbdev_read(HUDEV hudev, void *pdata, size_t ndata);
 size_t usbdev_write(HUDEV hudev, void const *pdata, size_t ndata);
 HANDLE usbdev_handle(HUDEV hudev);
+void usbdev_set_reportid(HUDEV hudev, BYTE reportid);
 
 
 